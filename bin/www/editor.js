@@ -206,6 +206,14 @@ function initCanvas() {
 
 let rgba = new Uint8ClampedArray(CANVAS_WIDTH * CANVAS_HEIGHT * 4);
 
+// tells the worker the frame buffer was copied, for programs waiting on vsync
+function takeFrame() {
+	const words = new Int32Array(memory.buffer);
+
+	Atomics.store(words, state.framesTakenPtr / 4, Atomics.load(words, state.framesPresentedPtr / 4));
+	Atomics.notify(words, state.framesTakenPtr / 4);
+}
+
 async function renderCanvas() {
 	handleScreen();
 
@@ -222,6 +230,8 @@ async function renderCanvas() {
 			rgba[i + 3] = 0xff;
 		}
 
+		takeFrame();
+
 		const img = await createImageBitmap(new ImageData(rgba, CANVAS_WIDTH, CANVAS_HEIGHT));
 		
 		if (isScreenSmall()) {
@@ -267,7 +277,9 @@ function makeWorker() {
 				downKeyPtr: msg.downKeyPtr,
 				aKeyPtr: msg.aKeyPtr,
 				bKeyPtr: msg.bKeyPtr,
-				timeSinceStartPtr: msg.timeSinceStartPtr
+				timeSinceStartPtr: msg.timeSinceStartPtr,
+				framesPresentedPtr: msg.framesPresentedPtr,
+				framesTakenPtr: msg.framesTakenPtr
 			};
 		}
 	
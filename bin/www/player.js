@@ -42,7 +42,9 @@ function makeWorker() {
 				downKeyPtr: msg.downKeyPtr,
 				aKeyPtr: msg.aKeyPtr,
 				bKeyPtr: msg.bKeyPtr,
-				timeSinceStartPtr: msg.timeSinceStartPtr
+				timeSinceStartPtr: msg.timeSinceStartPtr,
+				framesPresentedPtr: msg.framesPresentedPtr,
+				framesTakenPtr: msg.framesTakenPtr
 			};
 		}
 	}
@@ -216,6 +218,14 @@ function initCanvas() {
 
 let rgba = new Uint8ClampedArray(CANVAS_WIDTH * CANVAS_HEIGHT * 4);
 
+// tells the worker the frame buffer was copied, for programs waiting on vsync
+function takeFrame() {
+	const words = new Int32Array(memory.buffer);
+
+	Atomics.store(words, state.framesTakenPtr / 4, Atomics.load(words, state.framesPresentedPtr / 4));
+	Atomics.notify(words, state.framesTakenPtr / 4);
+}
+
 async function renderCanvas() {
 	clearCanvas();
 	
@@ -232,6 +242,8 @@ async function renderCanvas() {
 			rgba[i + 3] = 0xff;
 		}
 
+		takeFrame();
+
 		const img = await createImageBitmap(new ImageData(rgba, CANVAS_WIDTH, CANVAS_HEIGHT));
 		
 		if (isScreenSmall()) {
@@ -73,7 +73,8 @@ const env = {
 	js_get_string(obj, property, out)  { encode(out, obj[decode(property)]); },
 	js_get(obj, property)              { return obj[decode(property)]; },
 	
-	js_memcpy(dst, src, n)             { for (let i = 0; i < n; i++) memory[dst + i] = src[i]; }   
+	js_memcpy(dst, src, n)             { for (let i = 0; i < n; i++) memory[dst + i] = src[i]; },
+	js_now()                           { return performance.now(); }
 };
 	
 let wasm = null;
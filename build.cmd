@@ -34,6 +34,7 @@ set cli_libs= ^
 set web_flags=%common_flags% ^
 	-matomics ^
 	-mbulk-memory ^
+	-msimd128 ^
 	-Wno-incompatible-library-redeclaration ^
 	--target=wasm32 ^
 	-Xlinker --export-all ^
@@ -44,7 +45,10 @@ set web_flags=%common_flags% ^
 if "%cli%"=="true" (
 	set flags=%cli_flags% %cli_libs%
 
-	if "%release%"=="true" ( set flags=!flags! -Oz ) else ( set flags=!flags! -g3 )
+	if "%release%"=="true" ( set flags=!flags! -Oz ) else ( set flags=!flags! -g3 -DARENA_STATS )
+	if "%instrument%"=="true" ( set flags=!flags! -DPQ_INSTRUMENT )
+	if "%profile%"=="true" ( set flags=!flags! -DPQ_PROFILE )
+	if "%fixed%"=="true" ( set flags=!flags! -DPQ_FIXED_POINT )
 
 	echo building cli...
 	clang src/cli/main.c -o bin/cli.exe !flags!
@@ -55,6 +59,8 @@ if "%cli%"=="true" (
 if "%web%"=="true" (
 	set flags=%web_flags% -Oz
 
+	if "%fixed%"=="true" ( set flags=!flags! -DPQ_FIXED_POINT )
+
 	echo building web...
 	clang src/web/main.c -o bin/www/piqro.wasm !flags!
 
@@ -71,11 +77,15 @@ if "%hw%"=="true" (
 )
 
 if "%1"=="" ( 
-	echo usage: [%0] [targets...] [release]
+	echo usage: [%0] [targets...] [release] [instrument] [profile] [fixed]
 	echo.
 	echo possible targets:
 	echo - cli
 	echo - web
+	echo.
+	echo instrument counts vm instructions and calls in the cli, see PQ_INSTRUMENT
+	echo profile lets the cli sample call stacks with -profile, see PQ_PROFILE
+	echo fixed makes numbers fixed point instead of floats, see PQ_FIXED_POINT
 )
 
 :exit
@@ -2,12 +2,134 @@
 
 #include <base/common.h>
 
+//
+// instrumentation
+//
+// when built with ARENA_STATS, arenas that have stats attached record every push:
+// the peak offset, counts and bytes per tag (the subsystem the memory is for, 
+// see arena_set_tag) and per call site. pushes that are still alive get tracked 
+// until the arena is rewound past them, so whatever remains at the end of a run 
+// shows up in the report.
+//
+
+#define DEFINE_ARENA_TAGS \
+	TAG(OTHER) \
+	TAG(TOKENS) \
+	TAG(INSTRUCTIONS) \
+	TAG(SYMBOLS) \
+	TAG(BLOB) \
+	TAG(VM_STACK) \
+	TAG(STRINGS) \
+	TAG(CANVAS) \
+	TAG(SPRITES) \
+	TAG(TILEMAP) \
+	TAG(PARTICLES) \
+	TAG(COMMANDS)
+
+#define TAG(name) ARENA_TAG_##name,
+
+typedef enum : uint8_t
+{
+	DEFINE_ARENA_TAGS
+
+	ARENA_TAG_COUNT
+} ArenaTag;
+
+#undef TAG
+
+#define TAG(name) case ARENA_TAG_##name: return #name;
+
+static inline const char* arena_tag_to_c_str(const ArenaTag tag)
+{
+	switch (tag)
+	{
+		DEFINE_ARENA_TAGS
+
+		default: break;
+	}
+
+	return "unknown";
+}
+
+#undef TAG
+#undef DEFINE_ARENA_TAGS
+
+#if defined ARENA_STATS
+	static constexpr uint16_t ARENA_MAX_SITES = 128;
+	static constexpr uint16_t ARENA_MAX_RECORDS = 4096;
+
+	typedef struct
+	{
+		const char* file;
+		uint32_t line;
+
+		ArenaTag tag;
+
+		uint32_t count;
+		size_t bytes;
+		size_t live;
+	} ArenaSite;
+
+	typedef struct
+	{
+		size_t offset;
+		size_t size;
+
+		uint16_t site;
+	} ArenaRecord;
+
+	typedef struct
+	{
+		size_t peak;
+
+		uint32_t counts[ARENA_TAG_COUNT];
+		size_t bytes[ARENA_TAG_COUNT];
+		size_t live[ARENA_TAG_COUNT];
+
+		ArenaSite sites[ARENA_MAX_SITES];
+		uint16_t site_count;
+
+		// live pushes, in the order they were made
+		ArenaRecord records[ARENA_MAX_RECORDS];
+		uint16_t record_count;
+
+		// ran out of sites or records, the report is incomplete
+		bool overflow;
+	} ArenaStats;
+
+	#define ARENA_SITE , __FILE__, __LINE__
+	#define ARENA_SITE_PARAMS , const char* file, uint32_t line
+	#define ARENA_SITE_ARGS , file, line
+#else
+	#define ARENA_SITE
+	#define ARENA_SITE_PARAMS
+	#define ARENA_SITE_ARGS
+#endif
+
+//
+// arena
+//
+
 typedef struct Arena Arena;
 struct Arena
 {
 	uint8_t* buffer;
 	size_t offset;
 	size_t capacity;
+
+	// pushes stop here. whatever is above was pushed from the top (see
+	// arena_push_top_bytes_uninit) and stays until the arena is reset.
+	size_t top;
+
+	// everything past this point is known to be zero, so pushes only have 
+	// to clear memory below it. it only ever grows, rewinding the offset 
+	// (resets, scratches) leaves dirty memory behind.
+	size_t dirty;
+
+	#if defined ARENA_STATS
+		ArenaStats* stats;
+		ArenaTag tag;
+	#endif
 };
 
 static inline Arena arena_make(uint8_t* buffer, size_t capacity)
@@ -17,32 +139,243 @@ static inline Arena arena_make(uint8_t* buffer, size_t capacity)
 	arena.buffer = buffer;
 	arena.offset = 0;
 	arena.capacity = capacity;
+	arena.top = capacity;
+	arena.dirty = capacity;
 
 	return arena;
 }
 
-static inline void* _arena_push(Arena* arena, size_t size, size_t align)
+// for buffers that are known to be zero, like static storage or fresh pages
+// from the os. memory gets cleared lazily, only once it's reused.
+static inline Arena arena_make_zeroed(uint8_t* buffer, size_t capacity)
+{
+	Arena arena = arena_make(buffer, capacity);
+
+	arena.dirty = 0;
+
+	return arena;
+}
+
+#if defined __linux__
+	#include <sys/mman.h>
+
+	// reserves fresh pages from the os, the kernel zeroes them on first touch 
+	// so pushes don't have to. returns an empty arena if the mapping fails.
+	static inline Arena arena_reserve(size_t capacity)
+	{
+		void* buffer = mmap(nullptr, capacity, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+
+		if (buffer == MAP_FAILED)
+		{
+			return (Arena){};
+		}
+
+		return arena_make_zeroed((uint8_t*)buffer, capacity);
+	}
+#endif
+
+// returns the previous tag, so it can be restored once done
+static inline ArenaTag arena_set_tag(Arena* arena, ArenaTag tag)
+{
+	#if defined ARENA_STATS
+		ArenaTag previous = arena->tag;
+
+		arena->tag = tag;
+
+		return previous;
+	#else
+		(void)arena;
+		(void)tag;
+
+		return ARENA_TAG_OTHER;
+	#endif
+}
+
+#if defined ARENA_STATS
+	static inline void arena_attach_stats(Arena* arena, ArenaStats* stats)
+	{
+		*stats = (ArenaStats){};
+
+		arena->stats = stats;
+	}
+
+	static inline void arena_record(Arena* arena, size_t offset, size_t size, const char* file, uint32_t line)
+	{
+		ArenaStats* stats = arena->stats;
+
+		if (!stats)
+		{
+			return;
+		}
+
+		stats->peak = MAX(stats->peak, arena->offset);
+
+		stats->counts[arena->tag]++;
+		stats->bytes[arena->tag] += size;
+
+		uint16_t site = 0;
+
+		while (site < stats->site_count)
+		{
+			const ArenaSite* it = &stats->sites[site];
+
+			if (it->line == line && it->tag == arena->tag && it->file == file)
+			{
+				break;
+			}
+
+			site++;
+		}
+
+		if (site == stats->site_count)
+		{
+			if (stats->site_count >= ARENA_MAX_SITES)
+			{
+				stats->overflow = true;
+				return;
+			}
+
+			stats->sites[stats->site_count++] = (ArenaSite){ file, line, arena->tag };
+		}
+
+		stats->sites[site].count++;
+		stats->sites[site].bytes += size;
+
+		if (stats->record_count >= ARENA_MAX_RECORDS)
+		{
+			stats->overflow = true;
+			return;
+		}
+
+		stats->records[stats->record_count++] = (ArenaRecord){ offset, size, site };
+
+		stats->sites[site].live += size;
+		stats->live[arena->tag] += size;
+	}
+#endif
+
+// for memory that is fully written before being read
+static inline void* _arena_push_uninit(Arena* arena, size_t size, size_t align ARENA_SITE_PARAMS)
 {
 	size_t offset = __builtin_align_up(arena->offset, align);
 	
-	ASSERT(offset + size < arena->capacity);
+	ASSERT(offset + size < arena->top);
 
 	arena->offset = offset + size;
+	arena->dirty = MAX(arena->dirty, arena->offset);
 
-	uint8_t* ptr = arena->buffer + offset;
-	__builtin_memset(ptr, 0, size);
+	#if defined ARENA_STATS
+		arena_record(arena, offset, size, file, line);
+	#endif
+
+	return arena->buffer + offset;
+}
+
+static inline void* _arena_push(Arena* arena, size_t size, size_t align ARENA_SITE_PARAMS)
+{
+	size_t dirty = arena->dirty;
+
+	uint8_t* ptr = _arena_push_uninit(arena, size, align ARENA_SITE_ARGS);
+
+	size_t offset = ptr - arena->buffer;
+
+	if (offset < dirty)
+	{
+		__builtin_memset(ptr, 0, MIN(size, dirty - offset));
+	}
 
 	return ptr;
 }
 
+static inline void arena_rewind(Arena* arena, size_t offset)
+{
+	#if defined ARENA_STATS
+		ArenaStats* stats = arena->stats;
+
+		while (stats && stats->record_count > 0 && stats->records[stats->record_count - 1].offset >= offset)
+		{
+			ArenaRecord record = stats->records[--stats->record_count];
+
+			ArenaSite* site = &stats->sites[record.site];
+
+			site->live -= record.size;
+			stats->live[site->tag] -= record.size;
+		}
+	#endif
+
+	arena->offset = offset;
+}
+
+// gives back the end of the last push, for buffers reserved at their longest
+// and only partly written. size is what's kept of it.
+static inline void arena_trim(Arena* arena, void* last, size_t size)
+{
+	size_t offset = (uint8_t*)last - arena->buffer;
+
+	ASSERT(offset + size <= arena->offset);
+
+	#if defined ARENA_STATS
+		ArenaStats* stats = arena->stats;
+
+		if (stats && stats->record_count > 0 && stats->records[stats->record_count - 1].offset == offset)
+		{
+			ArenaRecord* record = &stats->records[stats->record_count - 1];
+
+			ArenaSite* site = &stats->sites[record->site];
+
+			site->bytes -= record->size - size;
+			site->live -= record->size - size;
+			stats->bytes[site->tag] -= record->size - size;
+			stats->live[site->tag] -= record->size - size;
+
+			record->size = size;
+		}
+	#endif
+
+	arena->offset = offset + size;
+}
+
+// pushes from the top of the arena down, for memory that stays until the arena
+// is reset, however far the offset gets rewound. returns nullptr instead of 
+// running into the memory pushed the usual way.
+static inline void* arena_push_top_bytes_uninit(Arena* arena, size_t size, size_t align)
+{
+	if (size > arena->top - arena->offset)
+	{
+		return nullptr;
+	}
+
+	size_t top = __builtin_align_down(arena->top - size, align);
+
+	if (top < arena->offset)
+	{
+		return nullptr;
+	}
+
+	arena->top = top;
+
+	return arena->buffer + top;
+}
+
 static inline void arena_reset(Arena* arena)
 {
-	arena->offset = 0;
+	arena_rewind(arena, 0);
+
+	// whatever was pushed from the top is left dirty
+	if (arena->top < arena->capacity)
+	{
+		arena->top = arena->capacity;
+		arena->dirty = arena->capacity;
+	}
 }
 
-#define arena_push(arena, T) ((T*)_arena_push((arena), sizeof(T), alignof(T)))
+#define arena_push(arena, T) ((T*)_arena_push((arena), sizeof(T), alignof(T) ARENA_SITE))
+
+#define arena_push_array(arena, T, N) ((T*)_arena_push((arena), sizeof(T) * (N), alignof(T) ARENA_SITE))
+
+#define arena_push_uninit(arena, T) ((T*)_arena_push_uninit((arena), sizeof(T), alignof(T) ARENA_SITE))
 
-#define arena_push_array(arena, T, N) ((T*)_arena_push((arena), sizeof(T) * (N), alignof(T)))
+#define arena_push_array_uninit(arena, T, N) ((T*)_arena_push_uninit((arena), sizeof(T) * (N), alignof(T) ARENA_SITE))
 
 typedef struct
 {
@@ -62,5 +395,239 @@ static inline Scratch scratch_make(Arena* arena)
 
 static inline void scratch_release(Scratch scratch)
 {
-	scratch.arena->offset = scratch.offset;
-}
\ No newline at end of file
+	arena_rewind(scratch.arena, scratch.offset);
+}
+
+//
+// pool
+//
+// size-class allocator on top of an arena, for memory that comes and goes
+// in no particular order. blocks are powers of two in size (header included), 
+// carved from the top of the arena as they're needed, so they don't take any 
+// memory up front and rewinding the arena leaves them alone. once carved they
+// never go back to the arena, freeing one makes it available to the next
+// allocation of the same class instead. when there's no room left for a whole 
+// power of two, blocks are carved to fit, and reused by anything they fit.
+//
+// live blocks are linked newest first, so everything allocated after a mark
+// can be freed at once (see pool_release).
+//
+
+static constexpr uint8_t POOL_MIN_CLASS = 5;
+static constexpr uint8_t POOL_CLASS_COUNT = 24;
+
+typedef struct PoolBlock PoolBlock;
+struct PoolBlock
+{
+	PoolBlock* newer;
+	PoolBlock* older;
+
+	// header included, a power of two unless the block was carved to fit
+	uint32_t size;
+
+	alignas(16) uint8_t data[];
+};
+
+typedef struct
+{
+	Arena* arena;
+
+	PoolBlock* free_lists[POOL_CLASS_COUNT];
+	PoolBlock* free_fitted;
+	PoolBlock* live;
+
+	size_t used;
+	size_t high_water;
+	size_t carved;
+} Pool;
+
+static inline Pool pool_make(Arena* arena)
+{
+	Pool pool = {};
+
+	pool.arena = arena;
+
+	return pool;
+}
+
+static inline PoolBlock* pool_carve(Pool* pool, size_t size)
+{
+	PoolBlock* block = (PoolBlock*)arena_push_top_bytes_uninit(pool->arena, size, alignof(PoolBlock));
+
+	if (block)
+	{
+		block->size = (uint32_t)size;
+
+		pool->carved += size;
+	}
+
+	return block;
+}
+
+// the first of the blocks carved to fit that's big enough
+static inline PoolBlock* pool_take_fitted(Pool* pool, size_t total)
+{
+	PoolBlock** it = &pool->free_fitted;
+
+	while (*it && (*it)->size < total)
+	{
+		it = &(*it)->older;
+	}
+
+	PoolBlock* block = *it;
+
+	if (block)
+	{
+		*it = block->older;
+	}
+
+	return block;
+}
+
+// returns nullptr when running out of memory. memory is only cleared when 
+// asked to, recycled blocks still hold whatever was written to them last.
+static inline void* pool_alloc(Pool* pool, size_t size, bool zero)
+{
+	size_t total = sizeof(PoolBlock) + size;
+
+	uint8_t size_class = MAX((uint8_t)(64 - __builtin_clzll(total - 1)), POOL_MIN_CLASS);
+
+	if (size_class >= POOL_CLASS_COUNT)
+	{
+		return nullptr;
+	}
+
+	PoolBlock* block = pool->free_lists[size_class];
+
+	if (block)
+	{
+		pool->free_lists[size_class] = block->older;
+	}
+	else
+	{
+		block = pool_carve(pool, (size_t)1 << size_class);
+	}
+
+	if (!block)
+	{
+		block = pool_take_fitted(pool, total);
+	}
+
+	if (!block)
+	{
+		block = pool_carve(pool, __builtin_align_up(total, alignof(PoolBlock)));
+	}
+
+	if (!block)
+	{
+		return nullptr;
+	}
+
+	block->newer = nullptr;
+	block->older = pool->live;
+
+	if (pool->live)
+	{
+		pool->live->newer = block;
+	}
+
+	pool->live = block;
+
+	pool->used += block->size;
+	pool->high_water = MAX(pool->high_water, pool->used);
+
+	if (zero)
+	{
+		__builtin_memset(block->data, 0, size);
+	}
+
+	return block->data;
+}
+
+static inline void pool_free(Pool* pool, void* ptr)
+{
+	PoolBlock* block = (PoolBlock*)((uint8_t*)ptr - __builtin_offsetof(PoolBlock, data));
+
+	if (block->newer)
+	{
+		block->newer->older = block->older;
+	}
+	else
+	{
+		pool->live = block->older;
+	}
+
+	if (block->older)
+	{
+		block->older->newer = block->newer;
+	}
+
+	pool->used -= block->size;
+
+	PoolBlock** list = &pool->free_fitted;
+
+	if ((block->size & (block->size - 1)) == 0)
+	{
+		list = &pool->free_lists[__builtin_ctz(block->size)];
+	}
+
+	block->older = *list;
+	*list = block;
+}
+
+static inline PoolBlock* pool_mark(const Pool* pool)
+{
+	return pool->live;
+}
+
+// frees every block allocated after `mark` that is still alive.
+static inline void pool_release(Pool* pool, PoolBlock* mark)
+{
+	while (pool->live && pool->live != mark)
+	{
+		pool_free(pool, pool->live->data);
+	}
+}
+
+#if defined ARENA_STATS
+	static inline void arena_print_stats(const Arena* arena)
+	{
+		const ArenaStats* stats = arena->stats;
+
+		if (!stats)
+		{
+			return;
+		}
+
+		printf("offset: %zu bytes, peak: %zu bytes, top: %zu bytes, capacity: %zu bytes\n", arena->offset, stats->peak, arena->top, arena->capacity);
+
+		printf("\n  %-14s | %-8s | %-10s | %-10s\n", "tag", "pushes", "bytes", "live");
+
+		for (uint8_t i = 0; i < ARENA_TAG_COUNT; i++)
+		{
+			if (stats->counts[i] == 0)
+			{
+				continue;
+			}
+
+			printf("  %-14s | %-8u | %-10zu | %-10zu\n", arena_tag_to_c_str(i), stats->counts[i], stats->bytes[i], stats->live[i]);
+		}
+
+		printf("\n  %-40s | %-14s | %-8s | %-10s | %-10s\n", "site", "tag", "pushes", "bytes", "live");
+
+		for (uint16_t i = 0; i < stats->site_count; i++)
+		{
+			const ArenaSite* it = &stats->sites[i];
+
+			char where[256] = {};
+			sprintf(where, "%s:%u", it->file, it->line);
+
+			printf("  %-40s | %-14s | %-8u | %-10zu | %-10zu\n", where, arena_tag_to_c_str(it->tag), it->count, it->bytes, it->live);
+		}
+
+		if (stats->overflow)
+		{
+			printf("\n  (incomplete, ran out of sites or records)\n");
+		}
+	}
+#endif
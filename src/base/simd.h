@@ -0,0 +1,165 @@
+#pragma once
+
+#include <base/common.h>
+
+//
+// simd
+//
+// bulk operations over int32_t and float arrays, 4 lanes at a time. the
+// vectors lower to sse on x86, simd128 on wasm (-msimd128) and to plain
+// scalar code anywhere else. tails are done one element at a time.
+//
+
+typedef int32_t SIMD_I32x4 __attribute__((vector_size(16)));
+typedef uint32_t SIMD_U32x4 __attribute__((vector_size(16)));
+typedef float SIMD_F32x4 __attribute__((vector_size(16)));
+
+static constexpr uint32_t SIMD_LANES = 4;
+
+// ints wrap around, add and mul take them as unsigned
+#define DEFINE_SIMD_KERNELS \
+	KERNELS(u32, uint32_t, SIMD_U32x4) \
+	KERNELS(i32, int32_t, SIMD_I32x4) \
+	KERNELS(f32, float, SIMD_F32x4)
+
+#define KERNELS(name, T, V) \
+	static inline V simd_load_##name(const T* p) { V v; __builtin_memcpy(&v, p, sizeof(V)); return v; } \
+	static inline void simd_store_##name(T* p, V v) { __builtin_memcpy(p, &v, sizeof(V)); } \
+	\
+	static inline void simd_fill_##name(T* a, uint32_t n, T v) \
+	{ \
+		const V vv = (V){} + v; \
+		uint32_t i = 0; \
+		\
+		for (; i + SIMD_LANES <= n; i += SIMD_LANES) simd_store_##name(a + i, vv); \
+		for (; i < n; i++) a[i] = v; \
+	} \
+	\
+	static inline void simd_add_##name(T* a, uint32_t n, T v) \
+	{ \
+		const V vv = (V){} + v; \
+		uint32_t i = 0; \
+		\
+		for (; i + SIMD_LANES <= n; i += SIMD_LANES) simd_store_##name(a + i, simd_load_##name(a + i) + vv); \
+		for (; i < n; i++) a[i] += v; \
+	} \
+	\
+	static inline void simd_mul_##name(T* a, uint32_t n, T v) \
+	{ \
+		const V vv = (V){} + v; \
+		uint32_t i = 0; \
+		\
+		for (; i + SIMD_LANES <= n; i += SIMD_LANES) simd_store_##name(a + i, simd_load_##name(a + i) * vv); \
+		for (; i < n; i++) a[i] *= v; \
+	} \
+	\
+	static inline void simd_accumulate_##name(T* a, const T* b, uint32_t n) \
+	{ \
+		uint32_t i = 0; \
+		\
+		for (; i + SIMD_LANES <= n; i += SIMD_LANES) simd_store_##name(a + i, simd_load_##name(a + i) + simd_load_##name(b + i)); \
+		for (; i < n; i++) a[i] += b[i]; \
+	}
+
+DEFINE_SIMD_KERNELS
+
+#undef KERNELS
+#undef DEFINE_SIMD_KERNELS
+
+// n has to be at least 1. lanes are picked with masks, ?: doesn't take vectors in C.
+#define DEFINE_SIMD_REDUCTIONS \
+	REDUCTION(min_i32, int32_t, SIMD_I32x4, i32, <) \
+	REDUCTION(max_i32, int32_t, SIMD_I32x4, i32, >) \
+	REDUCTION(min_f32, float, SIMD_F32x4, f32, <) \
+	REDUCTION(max_f32, float, SIMD_F32x4, f32, >)
+
+#define REDUCTION(name, T, V, type, op) \
+	static inline T simd_##name(const T* a, uint32_t n) \
+	{ \
+		V m = (V){} + a[0]; \
+		uint32_t i = 0; \
+		\
+		for (; i + SIMD_LANES <= n; i += SIMD_LANES) \
+		{ \
+			const V v = simd_load_##type(a + i); \
+			const SIMD_I32x4 pick = v op m; \
+			m = (V)(((SIMD_I32x4)v & pick) | ((SIMD_I32x4)m & ~pick)); \
+		} \
+		\
+		T r = m[0]; \
+		for (uint32_t l = 1; l < SIMD_LANES; l++) r = m[l] op r ? m[l] : r; \
+		for (; i < n; i++) r = a[i] op r ? a[i] : r; \
+		\
+		return r; \
+	}
+
+DEFINE_SIMD_REDUCTIONS
+
+#undef REDUCTION
+#undef DEFINE_SIMD_REDUCTIONS
+
+// floats are summed per lane, so the rounding differs slightly from a plain loop
+static inline float simd_dot_f32(const float* a, const float* b, uint32_t n)
+{
+	SIMD_F32x4 acc = {};
+	uint32_t i = 0;
+
+	for (; i + SIMD_LANES <= n; i += SIMD_LANES)
+	{
+		acc += simd_load_f32(a + i) * simd_load_f32(b + i);
+	}
+
+	float r = (acc[0] + acc[1]) + (acc[2] + acc[3]);
+
+	for (; i < n; i++)
+	{
+		r += a[i] * b[i];
+	}
+
+	return r;
+}
+
+static inline float simd_sum_f32(const float* a, uint32_t n)
+{
+	SIMD_F32x4 acc = {};
+	uint32_t i = 0;
+
+	for (; i + SIMD_LANES <= n; i += SIMD_LANES)
+	{
+		acc += simd_load_f32(a + i);
+	}
+
+	float r = (acc[0] + acc[1]) + (acc[2] + acc[3]);
+
+	for (; i < n; i++)
+	{
+		r += a[i];
+	}
+
+	return r;
+}
+
+// ints are accumulated in 64 bits, so these can't overflow for any array the vm can hold
+static inline int64_t simd_dot_i32(const int32_t* a, const int32_t* b, uint32_t n)
+{
+	int64_t r = 0;
+
+	for (uint32_t i = 0; i < n; i++)
+	{
+		r += (int64_t)a[i] * b[i];
+	}
+
+	return r;
+}
+
+static inline int64_t simd_sum_i32(const int32_t* a, uint32_t n)
+{
+	int64_t r = 0;
+
+	for (uint32_t i = 0; i < n; i++)
+	{
+		r += a[i];
+	}
+
+	return r;
+}
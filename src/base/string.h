@@ -15,6 +15,17 @@ struct String
 
 #define s_fmt(s) (int)(s).length, (s).buffer
 
+static inline char* str_push_buffer(Arena* arena, size_t length)
+{
+	ArenaTag tag = arena_set_tag(arena, ARENA_TAG_STRINGS);
+
+	char* buffer = arena_push_array_uninit(arena, char, length);
+
+	arena_set_tag(arena, tag);
+
+	return buffer;
+}
+
 static inline String str_copy_c_str(Arena* arena, const char* c_str)
 {
 	String s = {};
@@ -26,7 +37,7 @@ static inline String str_copy_c_str(Arena* arena, const char* c_str)
 		s.length++;
 	}
 
-	s.buffer = arena_push_array(arena, char, s.length);
+	s.buffer = str_push_buffer(arena, s.length);
 
 	for (size_t i = 0; i < s.length; i++)
 	{
@@ -41,7 +52,7 @@ static inline String str_copy(Arena* arena, String str)
 	String s = {};
 
 	s.length = str.length;
-	s.buffer = arena_push_array(arena, char, s.length);
+	s.buffer = str_push_buffer(arena, s.length);
 
 	for (size_t i = 0; i < s.length; i++)
 	{
@@ -56,7 +67,7 @@ static inline String str_copy_from_to(Arena* arena, String str, size_t a, size_t
 	String s = {};
 
 	s.length = b - a;
-	s.buffer = arena_push_array(arena, char, s.length);
+	s.buffer = str_push_buffer(arena, s.length);
 
 	for (size_t i = a; i < b; i++)
 	{
@@ -71,7 +82,7 @@ static inline String str_copy_c_str_from_to(Arena* arena, const char* str, size_
 	String s = {};
 
 	s.length = b - a;
-	s.buffer = arena_push_array(arena, char, s.length);
+	s.buffer = str_push_buffer(arena, s.length);
 
 	for (size_t i = a; i < b; i++)
 	{
@@ -95,6 +106,57 @@ static inline float str_as_number(String s)
 	return atof(out);
 }
 
+// parses decimal or hexadecimal (0x) integers, fails on anything else or on overflow
+static inline bool str_as_int(String s, int32_t* out)
+{
+	size_t i = 0;
+
+	bool negative = s.length > 0 && s.buffer[0] == '-';
+
+	if (negative)
+	{
+		i++;
+	}
+
+	uint32_t base = 10;
+
+	if (i + 1 < s.length && s.buffer[i] == '0' && (s.buffer[i + 1] == 'x' || s.buffer[i + 1] == 'X'))
+	{
+		base = 16;
+		i += 2;
+	}
+
+	if (i >= s.length)
+	{
+		return false;
+	}
+
+	int64_t v = 0;
+
+	for (; i < s.length; i++)
+	{
+		char ch = s.buffer[i];
+
+		uint32_t digit = 0;
+
+		if (ch >= '0' && ch <= '9')                    digit = ch - '0';
+		else if (base == 16 && ch >= 'a' && ch <= 'f') digit = ch - 'a' + 10;
+		else if (base == 16 && ch >= 'A' && ch <= 'F') digit = ch - 'A' + 10;
+		else                                           return false;
+
+		v = v * base + digit;
+
+		if (v > (int64_t)INT32_MAX + negative)
+		{
+			return false;
+		}
+	}
+
+	*out = (int32_t)(negative ? -v : v);
+
+	return true;
+}
+
 static inline String str_format(Arena* arena, const char* fmt, ...)
 {
 	char out[2048];
@@ -108,6 +170,232 @@ static inline String str_format(Arena* arena, const char* fmt, ...)
 	return str_copy_c_str(arena, out);
 }
 
+//
+// number formatting
+//
+
+static constexpr uint8_t STR_MAX_NUMBER_LENGTH = 32;
+
+static inline size_t str_write_uint(char* out, uint32_t v)
+{
+	char digits[10];
+	size_t count = 0;
+
+	do
+	{
+		digits[count++] = '0' + (v % 10);
+		v /= 10;
+	} while (v);
+
+	for (size_t i = 0; i < count; i++)
+	{
+		out[i] = digits[count - 1 - i];
+	}
+
+	return count;
+}
+
+static inline double str_pow10(int32_t p)
+{
+	static constexpr double POWERS[] = 
+	{
+		1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,  1e8,  1e9,  1e10, 1e11,
+		1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22,
+	};
+
+	bool negative = p < 0;
+
+	p = negative ? -p : p;
+
+	double r = 1.0;
+
+	while (p > 22)
+	{
+		r *= POWERS[22];
+		p -= 22;
+	}
+
+	r *= POWERS[p];
+
+	return negative ? 1.0 / r : r;
+}
+
+// x * 10^p, dividing for negative powers keeps small numbers exact
+static inline double str_scale10(double x, int32_t p)
+{
+	return p >= 0 ? x * str_pow10(p) : x / str_pow10(-p);
+}
+
+// writes the shortest decimal that reads back as the same float, no more than 
+// STR_MAX_NUMBER_LENGTH characters. integers take a fast path, very big or 
+// small numbers use an exponent (1.5e-7).
+static inline size_t str_write_number(char* out, float n)
+{
+	size_t length = 0;
+
+	if (n != n)
+	{
+		__builtin_memcpy(out, "nan", 3);
+		return 3;
+	}
+
+	if (n == 0.0f)
+	{
+		out[0] = '0';
+		return 1;
+	}
+
+	if (n < 0.0f)
+	{
+		out[length++] = '-';
+		n = -n;
+	}
+
+	if (n == __builtin_inff())
+	{
+		__builtin_memcpy(out + length, "inf", 3);
+		return length + 3;
+	}
+
+	// every integer up to 2^24 is exact
+	if (n < 16777216.0f && n == (float)(uint32_t)n)
+	{
+		return length + str_write_uint(out + length, (uint32_t)n);
+	}
+
+	double x = n;
+
+	// decimal exponent of the first digit, estimated from the binary one
+	uint32_t bits = 0;
+	__builtin_memcpy(&bits, &n, sizeof(float));
+
+	int32_t e = (int32_t)(((int32_t)((bits >> 23) & 0xff) - 127) * 0.30103);
+
+	while (str_pow10(e + 1) <= x) e++;
+	while (str_pow10(e) > x) e--;
+
+	// try more and more significant digits until the float round trips, 9 always do
+	uint32_t digits = 0;
+	int32_t count = 0;
+	int32_t exponent = e;
+
+	while (count < 9)
+	{
+		count++;
+
+		double d = __builtin_round(str_scale10(x, count - 1 - e));
+
+		// rounded up to the next power of ten
+		exponent = e;
+
+		if (d >= str_pow10(count))
+		{
+			d /= 10.0;
+			exponent++;
+		}
+
+		digits = (uint32_t)d;
+
+		if ((float)str_scale10(d, exponent - count + 1) == n)
+		{
+			break;
+		}
+	}
+
+	e = exponent;
+
+	while (count > 1 && digits % 10 == 0)
+	{
+		digits /= 10;
+		count--;
+	}
+
+	char d[10];
+	str_write_uint(d, digits);
+
+	if (e < -5 || e > 20)
+	{
+		out[length++] = d[0];
+
+		if (count > 1)
+		{
+			out[length++] = '.';
+
+			__builtin_memcpy(out + length, d + 1, count - 1);
+			length += count - 1;
+		}
+
+		out[length++] = 'e';
+
+		if (e < 0)
+		{
+			out[length++] = '-';
+		}
+
+		length += str_write_uint(out + length, (uint32_t)(e < 0 ? -e : e));
+	}
+	else if (e < 0)
+	{
+		out[length++] = '0';
+		out[length++] = '.';
+
+		for (int32_t i = 0; i < -e - 1; i++)
+		{
+			out[length++] = '0';
+		}
+
+		__builtin_memcpy(out + length, d, count);
+		length += count;
+	}
+	else
+	{
+		for (int32_t i = 0; i <= e; i++)
+		{
+			out[length++] = i < count ? d[i] : '0';
+		}
+
+		if (count > e + 1)
+		{
+			out[length++] = '.';
+
+			__builtin_memcpy(out + length, d + e + 1, count - e - 1);
+			length += count - e - 1;
+		}
+	}
+
+	return length;
+}
+
+static inline String str_from_int(Arena* arena, int32_t n)
+{
+	String s = {};
+
+	s.buffer = str_push_buffer(arena, STR_MAX_NUMBER_LENGTH);
+
+	if (n < 0)
+	{
+		s.buffer[s.length++] = '-';
+	}
+
+	s.length += str_write_uint(s.buffer + s.length, n < 0 ? -(uint32_t)n : (uint32_t)n);
+
+	arena_trim(arena, s.buffer, s.length);
+
+	return s;
+}
+
+static inline String str_from_number(Arena* arena, float n)
+{
+	String s = {};
+
+	s.buffer = str_push_buffer(arena, STR_MAX_NUMBER_LENGTH);
+	s.length = str_write_number(s.buffer, n);
+
+	arena_trim(arena, s.buffer, s.length);
+
+	return s;
+}
+
 static inline bool str_equals(String l, String r)
 {
 	if (l.length != r.length)
@@ -174,4 +462,73 @@ static inline size_t get_utf8_byte_count(char c)
 	}
 
 	return 0;
-}
\ No newline at end of file
+}
+
+// writes a signed fixed point number with the given fractional bits, using the 
+// fewest fractional digits that read back as the same value
+static inline size_t str_write_fixed(char* out, int32_t n, uint8_t fraction_bits)
+{
+	size_t length = 0;
+
+	if (n < 0)
+	{
+		out[length++] = '-';
+	}
+
+	uint32_t magnitude = n < 0 ? -(uint32_t)n : (uint32_t)n;
+	uint64_t one = 1ull << fraction_bits;
+	uint64_t fraction = magnitude & (one - 1);
+
+	length += str_write_uint(out + length, magnitude >> fraction_bits);
+
+	if (!fraction)
+	{
+		return length;
+	}
+
+	uint64_t digits = 0;
+	uint64_t scale = 1;
+	uint32_t count = 0;
+
+	while (count < 9)
+	{
+		count++;
+		scale *= 10;
+
+		digits = (fraction * scale + one / 2) / one;
+
+		if (digits < scale && (digits * one + scale / 2) / scale == fraction)
+		{
+			break;
+		}
+	}
+
+	out[length++] = '.';
+
+	for (uint32_t i = count; i > 0; i--)
+	{
+		out[length + i - 1] = '0' + (char)(digits % 10);
+		digits /= 10;
+	}
+
+	length += count;
+
+	while (out[length - 1] == '0')
+	{
+		length--;
+	}
+
+	return length;
+}
+
+static inline String str_from_fixed(Arena* arena, int32_t n, uint8_t fraction_bits)
+{
+	String s = {};
+
+	s.buffer = str_push_buffer(arena, STR_MAX_NUMBER_LENGTH);
+	s.length = str_write_fixed(s.buffer, n, fraction_bits);
+
+	arena_trim(arena, s.buffer, s.length);
+
+	return s;
+}
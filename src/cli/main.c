@@ -1,5 +1,19 @@
+#if defined __linux__
+	// clock_nanosleep (and mmap's MAP_ANONYMOUS), a strict c23 build hides them otherwise
+	#define _DEFAULT_SOURCE
+#endif
+
+#include <cli/trace.h>
+
 #include <pq/compiler.h>
 #include <pq/vm.h>
+#include <pq/profiler.h>
+
+#include <runtime/state.h>
+
+#include <cli/render.h>
+
+#include <time.h>
 
 void compiler_error_fn(uint16_t line, const char* what)
 {
@@ -13,31 +27,48 @@ void vm_error_fn(const char* what)
 	exit(1);
 }
 
-void print_proc(PQ_VM* vm)
+void rt_print(const char* s)
 {
-	Scratch scratch = scratch_make(vm->arena);
+	printf("%s", s);
+}
 
-	String v = pq_value_as_string(scratch.arena, pq_vm_get_local(vm, 0));
+// lets the frame test bed check that `present` reaches the trace
+void traced_frames_proc(PQ_VM* vm)
+{
+	pq_vm_return_value(vm, pq_value_int((int32_t)trace_frame_count()));
+}
 
-	printf("%.*s\n", s_fmt(v));
+// the runtime of the frame test bed
+static const RT_State* frames_rt = nullptr;
 
-	scratch_release(scratch);
+// reads the frame buffer, what the last `present` showed
+void pixel_proc(PQ_VM* vm)
+{
+	const int32_t x = pq_value_as_int(pq_vm_get_local(vm, 0));
+	const int32_t y = pq_value_as_int(pq_vm_get_local(vm, 1));
 
-	pq_vm_return(vm);
-}
+	const RT_Canvas* c = &frames_rt->canvas;
 
-void sin_proc(PQ_VM* vm)
-{
-	float v = pq_value_as_number(pq_vm_get_local(vm, 0));
+	if (x < 0 || y < 0 || x >= c->width || y >= c->height)
+	{
+		pq_vm_return_value(vm, pq_value_int(-1));
+		return;
+	}
 
-	pq_vm_return_value(vm, pq_value_number(__builtin_sinf(v)));
+	pq_vm_return_value(vm, pq_value_int(c->frame_buffer[y * c->width + x]));
 }
 
-void cos_proc(PQ_VM* vm)
+void print_proc(PQ_VM* vm)
 {
-	float v = pq_value_as_number(pq_vm_get_local(vm, 0));
+	Scratch scratch = scratch_make(vm->arena);
 
-	pq_vm_return_value(vm, pq_value_number(__builtin_cosf(v)));
+	String v = pq_value_as_string(scratch.arena, pq_vm_get_local(vm, 0));
+
+	printf("%.*s\n", s_fmt(v));
+
+	scratch_release(scratch);
+
+	pq_vm_return(vm);
 }
 
 void test_proc(PQ_VM* vm)
@@ -124,7 +155,7 @@ static void dump_instructions(PQ_Compiler* c)
 			{
 				printf("  %-4d | %-25s %d (%.*s)\n", i, pq_inst_to_c_str(it.type), it.arg, s_fmt(c->globals[it.arg].name));
 			}
-			else if (it.type == INST_STORE_GLOBAL)
+			else if (it.type == INST_STORE_GLOBAL || it.type == INST_STORE_GLOBAL_INT)
 			{
 				printf("  %-4d | %-25s %d (%.*s)\n", i, pq_inst_to_c_str(it.type), it.arg, s_fmt(c->globals[it.arg].name));
 			}
@@ -162,7 +193,7 @@ void dump_instruction(PQ_Compiler* c, PQ_VM* vm)
 		{
 			printf("\n-> %d | %-25s %d (%.*s)\n", vm->ip, pq_inst_to_c_str(it.type), it.arg, s_fmt(c->globals[it.arg].name));
 		}
-		else if (it.type == INST_STORE_GLOBAL)
+		else if (it.type == INST_STORE_GLOBAL || it.type == INST_STORE_GLOBAL_INT)
 		{
 			printf("\n-> %d | %-25s %d (%.*s)\n", vm->ip, pq_inst_to_c_str(it.type), it.arg, s_fmt(c->globals[it.arg].name));
 		}
@@ -192,51 +223,215 @@ void dump_state(PQ_VM* vm)
 	printf("stack size:  %d\n", vm->stack_size);
 	printf("call frame count: %d\n", vm->call_frame_count);
 
-	printf("\nVM memory consumption: %d bytes\n", vm->arena->offset);
+	printf("\nVM memory consumption: %zu bytes\n", vm->arena->offset);
+
+	#if defined ARENA_STATS
+		arena_print_stats(vm->arena);
+	#endif
+	printf("array memory: %zu bytes in use, %zu bytes at most, %zu bytes carved\n", vm->arrays.used, vm->arrays.high_water, vm->arrays.carved);
 }
 
-static constexpr const char source[] = 
+static FILE* profile_file = nullptr;
+
+static void write_profile_line(const char* line)
+{
+	fputs(line, profile_file);
+}
+
+#if defined PQ_INSTRUMENT
+	static uint64_t read_cycles()
+	{
+		#if defined __x86_64__ || defined __i386__
+			return __builtin_ia32_rdtsc();
+		#else
+			struct timespec ts;
+			clock_gettime(CLOCK_MONOTONIC, &ts);
+
+			return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+		#endif
+	}
+
+	static void write_stats_line(const char* line)
+	{
+		printf("%s", line);
+	}
+#endif
+
+// prime, so the samples don't keep landing on the same instructions of a loop
+static constexpr uint32_t PROFILE_INTERVAL = 97;
+
+static constexpr const char test_bed[] = 
 {
 	#embed "test_bed.pq" 
 	,
 	'\0'
 };
 
-int main()
+static constexpr const char test_bed_numbers[] = 
+{
+	#embed "test_bed_numbers.pq" 
+	,
+	'\0'
+};
+
+static constexpr const char test_bed_memory[] = 
+{
+	#embed "test_bed_memory.pq" 
+	,
+	'\0'
+};
+
+static constexpr const char test_bed_types[] = 
+{
+	#embed "test_bed_types.pq" 
+	,
+	'\0'
+};
+
+static constexpr const char test_bed_frames[] = 
+{
+	#embed "test_bed_frames.pq" 
+	,
+	'\0'
+};
+
+// frame mode programs never stop on their own, the cli stops them after this many frames
+static constexpr uint32_t TEST_FRAMES = 5;
+
+// seconds, for the runtime's delta_time and the frame pacing
+static double cli_clock()
+{
+	struct timespec ts;
+
+	#if defined __linux__
+		clock_gettime(CLOCK_MONOTONIC, &ts);
+	#else
+		timespec_get(&ts, TIME_UTC);
+	#endif
+
+	return (double)ts.tv_sec + (double)ts.tv_nsec / 1000000000.0;
+}
+
+static bool cli_should_stop()
+{
+	return false;
+}
+
+// sleeps until the next frame is due, like the web host does. a late frame
+// starts the schedule over, rather than rushing through the ones it missed.
+static void wait_for_frame(double* deadline)
+{
+	*deadline += 1.0 / RT_FRAME_RATE;
+
+	const double now = cli_clock();
+
+	if (*deadline <= now)
+	{
+		*deadline = now;
+		return;
+	}
+
+	#if defined __linux__
+		const struct timespec until = { (time_t)*deadline, (long)((*deadline - (double)(time_t)*deadline) * 1000000000.0) };
+
+		while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &until, nullptr) != 0) {}
+	#else
+		// the c runtime has nothing to sleep with everywhere else
+		while (cli_clock() < *deadline) {}
+	#endif
+}
+
+// calls update(dt) and draw() of a program in frame mode, once per frame
+static void run_frames(PQ_VM* vm, RT_State* rt)
+{
+	rt->clock = cli_clock;
+
+	double deadline = cli_clock();
+
+	for (uint32_t i = 0; i < TEST_FRAMES; i++)
+	{
+		wait_for_frame(&deadline);
+
+		if (!rt_run_frame(vm, cli_should_stop))
+		{
+			break;
+		}
+	}
+
+	// the last frame may still be rasterizing
+	rt_finish_render(rt);
+
+	printf("\nFrames: %u presented, %u traced\n", rt->frames_presented, trace_frame_count());
+}
+
+static bool is_flag(const char* arg, String flag)
+{
+	return str_equals((String){ (char*)arg, __builtin_strlen(arg) }, flag);
+}
+
+// test beds get the procedures of the runtime (print included) when `rt` is set, 
+// and its frames if they define update or draw
+static void run_test_bed(String source, Arena* compiler_arena, Arena* vm_arena, RT_State* rt)
 {
-	// NOTE: this amount of memory is sufficient to compile any program that's smaller than PQ_MAX_BLOB_SIZE.
-	static uint8_t compiler_mem[4 * 1024 * 1024];
-	
-	Arena compiler_arena = arena_make(compiler_mem, sizeof(compiler_mem));
-	
 	PQ_Compiler c = {};
 
 	{
-		pq_compiler_init(&c, &compiler_arena, s(source), compiler_error_fn);
+		pq_compiler_init(&c, compiler_arena, source, compiler_error_fn);
+
+		c.debug_info = true;
 	
-		pq_compiler_declare_foreign_proc(&c, s("print"), 1);
-		pq_compiler_declare_foreign_proc(&c, s("sin"), 1);
-		pq_compiler_declare_foreign_proc(&c, s("cos"), 1);
+		if (rt)
+		{
+			rt_declare_procedures(&c);
+			pq_compiler_declare_foreign_proc(&c, s("traced_frames"), 0);
+			pq_compiler_declare_foreign_proc(&c, s("pixel"), 2);
+		}
+		else
+		{
+			pq_compiler_declare_foreign_proc(&c, s("print"), 1);
+		}
+
 		pq_compiler_declare_foreign_proc(&c, s("test"), 2);
 	}
 
 	PQ_CompiledBlob b = pq_compile(&c);
 
-	static uint8_t vm_mem[128 * 1024];
-	Arena vm_arena = arena_make(vm_mem, sizeof(vm_mem));
-
 	PQ_VM vm = {};
 
 	dump_procedures(&c);
 	dump_instructions(&c);
 
 	{
-		pq_vm_init(&vm, &vm_arena, &b, vm_error_fn);
+		pq_vm_init(&vm, vm_arena, &b, vm_error_fn);
 	
-		pq_vm_bind_foreign_proc(&vm, s("print"), print_proc);
-		pq_vm_bind_foreign_proc(&vm, s("sin"), sin_proc);
-		pq_vm_bind_foreign_proc(&vm, s("cos"), cos_proc);
+		if (rt)
+		{
+			rt_bind_procedures(&vm);
+			pq_vm_bind_foreign_proc(&vm, s("traced_frames"), traced_frames_proc);
+			pq_vm_bind_foreign_proc(&vm, s("pixel"), pixel_proc);
+		}
+		else
+		{
+			pq_vm_bind_foreign_proc(&vm, s("print"), print_proc);
+		}
+
 		pq_vm_bind_foreign_proc(&vm, s("test"), test_proc);
+
+		#if defined PQ_INSTRUMENT
+			static PQ_VMStats vm_exec_stats;
+			pq_vm_attach_stats(&vm, &vm_exec_stats, read_cycles);
+		#endif
+
+		#if defined PQ_PROFILE
+			static PQ_Profiler profiler;
+
+			if (profile_file)
+			{
+				pq_profiler_init(&profiler, compiler_arena, PROFILE_INTERVAL);
+
+				vm.profiler = &profiler;
+			}
+		#endif
 	
 		do
 		{
@@ -245,8 +440,147 @@ int main()
 			//dump_state(&vm);
 			//dump_instruction(&c, &vm);
 		} while (pq_execute(&vm));
+
+		if (rt && rt_frames_wanted(&vm))
+		{
+			run_frames(&vm, rt);
+		}
+	}
+
+	// stacks of every test bed go to the same file, flame graph tools add up repeated ones
+	#if defined PQ_PROFILE
+		if (vm.profiler)
+		{
+			pq_profiler_write_folded(vm.profiler, &vm, write_profile_line);
+
+			printf("\nProfile: %u samples, %u dropped\n", vm.profiler->samples, vm.profiler->dropped);
+		}
+	#endif
+
+	#if defined PQ_INSTRUMENT
+		printf("\nVM execution:\n");
+		pq_vm_write_stats(&vm, write_stats_line);
+	#endif
+
+	#if defined ARENA_STATS
+		printf("\nCompiler memory:\n");
+		arena_print_stats(compiler_arena);
+
+		printf("\nVM memory:\n");
+		arena_print_stats(vm_arena);
+	#endif
+}
+
+// usage: cli [-profile out.folded] [-trace out.json]
+int main(int argc, char** argv)
+{
+	const char* profile_path = nullptr;
+	const char* trace_path = nullptr;
+
+	for (int i = 1; i + 1 < argc; i += 2)
+	{
+		if (is_flag(argv[i], s("-profile")))
+		{
+			profile_path = argv[i + 1];
+		}
+		else if (is_flag(argv[i], s("-trace")))
+		{
+			trace_path = argv[i + 1];
+		}
+	}
+
+	// always on, -trace only decides whether it's written out
+	trace_start();
+
+	#if defined PQ_PROFILE
+		if (profile_path)
+		{
+			profile_file = fopen(profile_path, "w");
+		}
+	#else
+		if (profile_path)
+		{
+			printf("-profile needs a build with PQ_PROFILE\n");
+		}
+	#endif
+
+	// NOTE: this amount of memory is sufficient to compile any program that's smaller than PQ_MAX_BLOB_SIZE.
+	#if defined __linux__
+		Arena compiler_arena = arena_reserve(4 * 1024 * 1024);
+	#else
+		static uint8_t compiler_mem[4 * 1024 * 1024];
+	
+		Arena compiler_arena = arena_make_zeroed(compiler_mem, sizeof(compiler_mem));
+	#endif
+
+	#if defined ARENA_STATS
+		static ArenaStats compiler_stats;
+		arena_attach_stats(&compiler_arena, &compiler_stats);
+	#endif
+
+	static uint8_t vm_mem[128 * 1024];
+	Arena vm_arena = arena_make_zeroed(vm_mem, sizeof(vm_mem));
+
+	#if defined ARENA_STATS
+		static ArenaStats vm_stats;
+		arena_attach_stats(&vm_arena, &vm_stats);
+	#endif
+
+	// the runtime needs a lot more memory, for its canvas and everything else
+	static uint8_t rt_mem[384 * 1024];
+	Arena rt_arena = arena_make_zeroed(rt_mem, sizeof(rt_mem));
+
+	// each test bed is a program of its own, a single blob only fits so many tests
+	const String test_beds[] = { s(test_bed), s(test_bed_numbers), s(test_bed_memory), s(test_bed_types) };
+
+	for (size_t i = 0; i < sizeof(test_beds) / sizeof(test_beds[0]); i++)
+	{
+		run_test_bed(test_beds[i], &compiler_arena, &vm_arena, nullptr);
+
+		arena_reset(&compiler_arena);
+		arena_reset(&vm_arena);
+	}
+
+	// frame mode only exists with the runtime
+	{
+		RT_State rt = {};
+
+		rt_state_init(&rt_arena, &rt);
+
+		frames_rt = &rt;
+
+		// deferred mode rasterizes on worker threads where there are any
+		render_start(&rt);
+
+		run_test_bed(s(test_bed_frames), &compiler_arena, &rt_arena, &rt);
+
+		render_stop(&rt);
+	}
+
+	if (profile_file)
+	{
+		fclose(profile_file);
+
+		printf("\nProfile written to %s\n", profile_path);
+	}
+
+	if (trace_path && trace_write_json(trace_path))
+	{
+		printf("\nTrace written to %s\n", trace_path);
 	}
 }
 
 #include <pq/compiler.c>
-#include <pq/vm.c>
\ No newline at end of file
+#include <pq/vm.c>
+#include <pq/profiler.c>
+
+#include <runtime/canvas.c>
+#include <runtime/sprite.c>
+#include <runtime/tilemap.c>
+#include <runtime/commands.c>
+#include <runtime/collision.c>
+#include <runtime/particles.c>
+#include <runtime/state.c>
+
+#include <cli/trace.c>
+#include <cli/render.c>
\ No newline at end of file
@@ -0,0 +1,147 @@
+#include <cli/render.h>
+
+#if defined __linux__
+
+#include <pthread.h>
+
+static pthread_t render_threads[RT_RENDER_BANDS];
+
+static pthread_mutex_t render_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t render_wake = PTHREAD_COND_INITIALIZER;
+static pthread_cond_t render_done = PTHREAD_COND_INITIALIZER;
+
+// everything below is only accessed with render_lock held.
+// every batch gets a new generation, workers rasterize their band once for each.
+static RT_State* render_state = nullptr;
+static uint32_t render_generation = 0;
+static uint8_t render_remaining = 0;
+static bool render_quit = false;
+
+static void* render_worker(void* arg)
+{
+	const uint8_t band = (uint8_t)(uintptr_t)arg;
+
+	// render_start counts from 0 before any worker runs, so none misses the first batch
+	uint32_t generation = 0;
+
+	pthread_mutex_lock(&render_lock);
+
+	for (;;)
+	{
+		while (render_generation == generation && !render_quit)
+		{
+			pthread_cond_wait(&render_wake, &render_lock);
+		}
+
+		if (render_quit)
+		{
+			break;
+		}
+
+		generation = render_generation;
+
+		RT_State* s = render_state;
+
+		pthread_mutex_unlock(&render_lock);
+
+		rt_render_band(s, band);
+
+		pthread_mutex_lock(&render_lock);
+
+		if (--render_remaining == 0)
+		{
+			pthread_cond_signal(&render_done);
+		}
+	}
+
+	pthread_mutex_unlock(&render_lock);
+
+	return nullptr;
+}
+
+static void render(RT_State* s)
+{
+	pthread_mutex_lock(&render_lock);
+
+	render_state = s;
+	render_remaining = RT_RENDER_BANDS;
+	render_generation++;
+
+	pthread_cond_broadcast(&render_wake);
+	pthread_mutex_unlock(&render_lock);
+}
+
+static void finish(RT_State* s)
+{
+	pthread_mutex_lock(&render_lock);
+
+	while (render_remaining > 0)
+	{
+		pthread_cond_wait(&render_done, &render_lock);
+	}
+
+	pthread_mutex_unlock(&render_lock);
+}
+
+static void join_workers(uint8_t count)
+{
+	pthread_mutex_lock(&render_lock);
+
+	render_quit = true;
+
+	pthread_cond_broadcast(&render_wake);
+	pthread_mutex_unlock(&render_lock);
+
+	for (uint8_t i = 0; i < count; i++)
+	{
+		pthread_join(render_threads[i], nullptr);
+	}
+
+	render_quit = false;
+}
+
+//
+// interface
+//
+
+bool render_start(RT_State* rt)
+{
+	render_generation = 0;
+
+	for (uint8_t i = 0; i < RT_RENDER_BANDS; i++)
+	{
+		if (pthread_create(&render_threads[i], nullptr, render_worker, (void*)(uintptr_t)i) != 0)
+		{
+			join_workers(i);
+			return false;
+		}
+	}
+
+	rt->render = render;
+	rt->finish = finish;
+
+	return true;
+}
+
+void render_stop(RT_State* rt)
+{
+	rt_finish_render(rt);
+
+	rt->render = nullptr;
+	rt->finish = nullptr;
+
+	join_workers(RT_RENDER_BANDS);
+}
+
+#else
+
+bool render_start(RT_State* rt)
+{
+	return false;
+}
+
+void render_stop(RT_State* rt)
+{
+}
+
+#endif
@@ -0,0 +1,20 @@
+#pragma once
+
+#include <base/common.h>
+
+#include <runtime/state.h>
+
+//
+// render
+//
+// rasterizes deferred frames on RT_RENDER_BANDS worker threads, a band each,
+// while the program goes on recording the next frame (see RT_RenderFn). the
+// workers sleep on a condition variable between batches. anywhere but linux
+// there are no threads to use, the runtime rasterizes the bands itself.
+//
+
+// starts the workers and hooks them up to `rt`, returns false if it can't
+bool render_start(RT_State* rt);
+
+// waits for what's being rasterized, then stops the workers
+void render_stop(RT_State* rt);
@@ -0,0 +1,165 @@
+#include <cli/trace.h>
+
+#include <time.h>
+
+static TraceEvent trace_events[TRACE_CAPACITY];
+static uint32_t trace_next = 0;
+
+static bool trace_on = false;
+static double trace_origin = 0.0;
+
+// since trace_origin
+static double trace_frame_start = 0.0;
+static uint32_t trace_frames = 0;
+
+static double now_us()
+{
+	struct timespec ts;
+	timespec_get(&ts, TIME_UTC);
+
+	return (double)ts.tv_sec * 1000000.0 + (double)ts.tv_nsec / 1000.0;
+}
+
+static void record(String name, char phase, double ts, double duration)
+{
+	if (!trace_on)
+	{
+		return;
+	}
+
+	const uint32_t position = __atomic_fetch_add(&trace_next, 1, __ATOMIC_RELAXED);
+
+	TraceEvent* e = &trace_events[position % TRACE_CAPACITY];
+
+	// foreign procedures only have names with debug info
+	e->name = name.length > 0 ? name : s("foreign");
+	e->ts = ts;
+	e->phase = phase;
+	e->duration = duration;
+
+	__atomic_store_n(&e->sequence, position + 1, __ATOMIC_RELEASE);
+}
+
+static void write_name(FILE* f, String name)
+{
+	for (size_t i = 0; i < name.length; i++)
+	{
+		const char c = name.buffer[i];
+
+		if (c == '"' || c == '\\')
+		{
+			fputc('\\', f);
+		}
+
+		if ((uint8_t)c >= ' ')
+		{
+			fputc(c, f);
+		}
+	}
+}
+
+//
+// interface
+//
+
+void trace_start()
+{
+	trace_next = 0;
+	trace_origin = now_us();
+	trace_frame_start = 0.0;
+	trace_frames = 0;
+	trace_on = true;
+}
+
+void trace_begin(String name)
+{
+	record(name, 'B', now_us() - trace_origin, 0.0);
+}
+
+void trace_end(String name)
+{
+	record(name, 'E', now_us() - trace_origin, 0.0);
+}
+
+void trace_frame(String name)
+{
+	const double now = now_us() - trace_origin;
+
+	record(name, 'X', trace_frame_start, now - trace_frame_start);
+
+	trace_frame_start = now;
+
+	if (trace_on)
+	{
+		__atomic_fetch_add(&trace_frames, 1, __ATOMIC_RELAXED);
+	}
+}
+
+uint32_t trace_frame_count()
+{
+	return __atomic_load_n(&trace_frames, __ATOMIC_ACQUIRE);
+}
+
+bool trace_write_json(const char* path)
+{
+	FILE* f = fopen(path, "w");
+
+	if (!f)
+	{
+		return false;
+	}
+
+	const uint32_t last = __atomic_load_n(&trace_next, __ATOMIC_ACQUIRE);
+	const uint32_t first = last > TRACE_CAPACITY ? last - TRACE_CAPACITY : 0;
+
+	// the ends of spans that began before the oldest event are dropped
+	uint32_t depth = 0;
+	double ts = 0.0;
+
+	fprintf(f, "{\"traceEvents\":[\n");
+
+	// names the timeline of the frames, so every event after this one starts with a comma
+	fprintf(f, "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":2,\"args\":{\"name\":\"frames\"}}");
+
+	for (uint32_t i = first; i < last; i++)
+	{
+		const TraceEvent* e = &trace_events[i % TRACE_CAPACITY];
+
+		if (__atomic_load_n(&e->sequence, __ATOMIC_ACQUIRE) != i + 1)
+		{
+			continue;
+		}
+
+		if (e->phase == 'X')
+		{
+			fprintf(f, ",\n{\"name\":\"");
+			write_name(f, e->name);
+			fprintf(f, "\",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f,\"pid\":1,\"tid\":2}", e->ts, e->duration);
+
+			continue;
+		}
+
+		if (e->phase == 'E' && depth == 0)
+		{
+			continue;
+		}
+
+		depth += e->phase == 'B' ? 1 : -1;
+		ts = e->ts;
+
+		fprintf(f, ",\n{\"name\":\"");
+		write_name(f, e->name);
+		fprintf(f, "\",\"ph\":\"%c\",\"ts\":%.3f,\"pid\":1,\"tid\":1}", e->phase, e->ts);
+	}
+
+	// close whatever is still open
+	for (; depth > 0; depth--)
+	{
+		fprintf(f, ",\n{\"ph\":\"E\",\"ts\":%.3f,\"pid\":1,\"tid\":1}", ts);
+	}
+
+	fprintf(f, "\n]}\n");
+	fclose(f);
+
+	return true;
+}
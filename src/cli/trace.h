@@ -0,0 +1,60 @@
+#pragma once
+
+#include <base/common.h>
+#include <base/string.h>
+
+//
+// trace
+//
+// spans recorded by the PQ_TRACE_BEGIN/END hooks (see pq/config.h), dumped in
+// the chrome trace event format that chrome://tracing and perfetto open. the
+// events go into a fixed ring buffer: writers claim a slot with an atomic add
+// instead of taking a lock, and the oldest events get overwritten once it's
+// full. spans go on one timeline. frames (PQ_TRACE_FRAME) are complete events
+// on a timeline of their own, since they start and end in the middle of the
+// `present` call. nothing is recorded until trace_start, the cli starts it
+// right away so its frame test bed can count frames, -trace only writes them.
+//
+// include this before anything from pq, so the hooks are defined first.
+//
+
+static constexpr uint32_t TRACE_CAPACITY = 1 << 15;
+
+typedef struct TraceEvent TraceEvent;
+struct TraceEvent
+{
+	String name;
+
+	// microseconds since trace_start
+	double ts;
+
+	// 'B', 'E', or 'X' for frames
+	char phase;
+
+	// microseconds, frames only
+	double duration;
+
+	// the position it was written at, plus one. a reader skips slots
+	// whose sequence doesn't match, they're being written over.
+	uint32_t sequence;
+};
+
+void trace_start();
+
+void trace_begin(String name);
+
+void trace_end(String name);
+
+// ends the frame that started at the previous call (or trace_start), and starts the next
+void trace_frame(String name);
+
+// frames ended since trace_start, including those written over in the buffer
+uint32_t trace_frame_count();
+
+// writes everything still in the buffer to `path`. spans cut in half by the
+// buffer wrapping around, or still open, are left out or closed at the end.
+bool trace_write_json(const char* path);
+
+#define PQ_TRACE_BEGIN(name) trace_begin((name))
+#define PQ_TRACE_END(name) trace_end((name))
+#define PQ_TRACE_FRAME(name) trace_frame((name))
@@ -56,6 +56,24 @@ static constexpr struct
 	{ TOKEN_FOREIGN, s("foreign") },
 };
 
+// calls to these compile to a single instruction, unless the program defines 
+// a procedure with the same name
+static constexpr struct 
+{
+	PQ_InstructionType type;
+	String name;
+} INTRINSICS[] =
+{
+	{ INST_ABS,   s("abs") },
+	{ INST_FLOOR, s("floor") },
+	{ INST_CEIL,  s("ceil") },
+	{ INST_SQRT,  s("sqrt") },
+	{ INST_SIN,   s("sin") },
+	{ INST_COS,   s("cos") },
+	{ INST_TAN,   s("tan") },
+	{ INST_ATAN,  s("atan") },
+};
+
 static PQ_Token parse_identifier(PQ_Compiler* c)
 {
 	PQ_Token t = {};
@@ -480,6 +498,12 @@ static void tokenize(PQ_Compiler* c)
 				push_token(c, (PQ_Token){ TOKEN_COMMA, c->line });		
 			} break;
 
+			case ':':
+			{
+				eat_char(c);
+				push_token(c, (PQ_Token){ TOKEN_COLON, c->line });
+			} break;
+
 			case '\'':
 			{
 				push_token(c, parse_string(c));
@@ -550,11 +574,47 @@ static PQ_Token try_eat_token(PQ_Compiler* c, PQ_TokenType expected)
 
 static PQ_Instruction* push_inst(PQ_Compiler* c, PQ_Instruction it)
 {
+	c->instruction_lines[c->instruction_count] = c->line;
 	c->instructions[c->instruction_count++] = it;
 
 	return &c->instructions[c->instruction_count - 1];
 }
 
+// whether the instructions in [first, last) could observe the value of `var`.
+// calls are assumed to, since procedures can reach globals.
+static bool variable_read(PQ_Compiler* c, const PQ_Variable* var, uint16_t first, uint16_t last)
+{
+	for (uint16_t i = first; i < last; i++)
+	{
+		PQ_Instruction it = c->instructions[i];
+
+		switch (it.type)
+		{
+			case INST_CALL: 
+				return true;
+
+			case INST_LOAD_LOCAL:
+			case INST_LOAD_LOCAL_SUBSCRIPT:
+			case INST_LOAD_LOCAL_INT_SUBSCRIPT:
+			case INST_LOAD_LOCAL_NUMBER_SUBSCRIPT:
+				if (!var->global && it.arg == var->idx) return true;
+				break;
+
+			case INST_LOAD_GLOBAL:
+			case INST_LOAD_GLOBAL_SUBSCRIPT:
+			case INST_LOAD_GLOBAL_INT_SUBSCRIPT:
+			case INST_LOAD_GLOBAL_NUMBER_SUBSCRIPT:
+				if (var->global && it.arg == var->idx) return true;
+				break;
+
+			default: 
+				break;
+		}
+	}
+
+	return false;
+}
+
 static bool variable_exists(PQ_Compiler* c, String name)
 {	
 	for (uint16_t i = 0; i < c->local_count; i++)
@@ -589,6 +649,28 @@ static bool procedure_exists(PQ_Compiler* c, String name)
 	return false;
 }
 
+static bool get_intrinsic(PQ_Compiler* c, String name, PQ_InstructionType* out)
+{
+	for (uint16_t i = 0; i < c->procedure_count; i++)
+	{
+		if (str_equals(c->procedures[i].name, name) && !c->procedures[i].foreign)
+		{
+			return false;
+		}
+	}
+
+	for (size_t i = 0; i < COUNT_OF(INTRINSICS); i++)
+	{
+		if (str_equals(INTRINSICS[i].name, name))
+		{
+			*out = INTRINSICS[i].type;
+			return true;
+		}
+	}
+
+	return false;
+}
+
 static PQ_Procedure* get_or_create_procedure(PQ_Compiler* c, String name)
 {
 	for (uint16_t i = 0; i < c->procedure_count; i++)
@@ -601,8 +683,11 @@ static PQ_Procedure* get_or_create_procedure(PQ_Compiler* c, String name)
 
 	PQ_Procedure* proc = &c->procedures[c->procedure_count++];
 	
+	*proc = (PQ_Procedure){};
+
 	proc->name = name;
 	proc->idx = c->procedure_count - 1;
+	proc->ordinal = PQ_FOREIGN_UNREGISTERED;
 
 	return proc;
 }
@@ -629,6 +714,8 @@ static PQ_Variable* get_or_create_variable(PQ_Compiler* c, String name)
 	{
 		PQ_Variable* var = &c->locals[c->local_count++];
 			
+		*var = (PQ_Variable){};
+
 		var->name = name;
 		var->idx = c->local_count - 1;
 		var->global = false;
@@ -644,6 +731,8 @@ static PQ_Variable* get_or_create_variable(PQ_Compiler* c, String name)
 	{
 		PQ_Variable* var = &c->globals[c->global_count++];
 		
+		*var = (PQ_Variable){};
+
 		var->name = name;
 		var->idx = c->global_count - 1;
 		var->global = true;
@@ -656,7 +745,9 @@ static uint16_t get_or_create_immediate(PQ_Compiler* c, PQ_Value v)
 {
 	for (uint16_t i = 0; i < c->immediate_count; i++)
 	{
-		if (pq_value_equals(c->immediates[i], v).b)
+		// 1 and 1.0 are equal, but not the same immediate. ints are compared as 
+		// they are, as floats big ones would look the same
+		if (c->immediates[i].type == v.type && (v.type == VALUE_INT ? c->immediates[i].i == v.i : pq_value_equals(c->immediates[i], v).b))
 		{
 			return i;
 		}
@@ -667,6 +758,125 @@ static uint16_t get_or_create_immediate(PQ_Compiler* c, PQ_Value v)
 	return c->immediate_count - 1;
 }
 
+// whether the value the last expression left on the stack could be an array.
+// only reading a variable or an element gives one, since procedures can't 
+// return arrays and everything else computes a new value.
+static bool may_be_array(const PQ_Compiler* c)
+{
+	switch (c->instructions[c->instruction_count - 1].type)
+	{
+		case INST_LOAD_LOCAL:
+		case INST_LOAD_GLOBAL:
+		case INST_LOAD_LOCAL_SUBSCRIPT:
+		case INST_LOAD_GLOBAL_SUBSCRIPT:
+		case INST_LOAD_LOCAL_INT_SUBSCRIPT:
+		case INST_LOAD_GLOBAL_INT_SUBSCRIPT:
+		case INST_LOAD_LOCAL_NUMBER_SUBSCRIPT:
+		case INST_LOAD_GLOBAL_NUMBER_SUBSCRIPT:
+			return true;
+
+		default: return false;
+	}
+}
+
+// called when an array may get stored into the local `idx`, or somewhere that
+// outlives the procedure for -1 (a global, an array element). the loop bodies 
+// around the store that the local doesn't belong to keep their arrays then.
+static void escape_scopes(PQ_Compiler* c, int32_t idx)
+{
+	if (idx < 0 && c->current_proc)
+	{
+		c->current_proc->stores_arrays = true;
+	}
+
+	for (PQ_Scope* it = c->current_scope; it && idx < it->local_base; it = it->previous)
+	{
+		it->escapes = true;
+	}
+}
+
+// an array may get stored into `var` itself
+static void store_array(PQ_Compiler* c, PQ_Variable* var)
+{
+	escape_scopes(c, var->global ? -1 : var->idx);
+
+	// the arrays stored in its elements so far may belong to this one
+	if (var->holds_arrays)
+	{
+		escape_scopes(c, -1);
+	}
+
+	var->borrows = true;
+}
+
+// an array may get stored into an element of `var`. that's as good as storing
+// it into `var`, as long as the array it holds is one it allocated.
+static void store_array_element(PQ_Compiler* c, PQ_Variable* var)
+{
+	escape_scopes(c, var->global || var->borrows ? -1 : var->idx);
+
+	var->holds_arrays = true;
+}
+
+// whether the value the last expression left on the stack is sure to be an int:
+// an int literal, a variable declared `: int` or a bitwise result. the int 
+// opcodes don't check their operands, anything else takes the generic ones.
+static bool is_int(const PQ_Compiler* c)
+{
+	const PQ_Instruction it = c->instructions[c->instruction_count - 1];
+
+	switch (it.type)
+	{
+		case INST_LOAD_IMMEDIATE: return c->immediates[it.arg].type == VALUE_INT;
+		case INST_LOAD_LOCAL:     return c->locals[it.arg].is_int;
+		case INST_LOAD_GLOBAL:    return c->globals[it.arg].is_int;
+
+		case INST_BW_OR:
+		case INST_BW_AND:
+		case INST_BW_XOR:
+		case INST_BW_LEFT_SHIFT:
+		case INST_BW_RIGHT_SHIFT:
+			return true;
+
+		default: return false;
+	}
+}
+
+// the int opcode for an operation on two known ints, or the generic one
+static PQ_InstructionType int_inst(PQ_InstructionType type, bool ints)
+{
+	if (!ints)
+	{
+		return type;
+	}
+
+	switch (type)
+	{
+		case INST_ADD:          return INST_ADD_INT;
+		case INST_SUB:          return INST_SUB_INT;
+		case INST_MUL:          return INST_MUL_INT;
+		case INST_MOD:          return INST_MOD_INT;
+		case INST_GREATER_THAN: return INST_GREATER_THAN_INT;
+		case INST_LESS_THAN:    return INST_LESS_THAN_INT;
+		case INST_EQUALS:       return INST_EQUALS_INT;
+		case INST_GREATER:      return INST_GREATER_INT;
+		case INST_LESS:         return INST_LESS_INT;
+
+		default: return type;
+	}
+}
+
+// int variables only convert what isn't known to be an int already
+static PQ_InstructionType store_inst(const PQ_Compiler* c, const PQ_Variable* var)
+{
+	if (var->is_int && !is_int(c))
+	{
+		return var->global ? INST_STORE_GLOBAL_INT : INST_STORE_LOCAL_INT;
+	}
+
+	return var->global ? INST_STORE_GLOBAL : INST_STORE_LOCAL;
+}
+
 static void emit_expression(PQ_Compiler* c);
 
 static void emit_statement(PQ_Compiler* c);
@@ -682,13 +892,28 @@ static void emit_null_expression(PQ_Compiler* c)
 	push_inst(c, (PQ_Instruction){ INST_LOAD_NULL });
 }
 
-static void emit_number_expression(PQ_Compiler* c)
+// negative literals are loaded as they are, so they stay ints
+static void emit_number_expression(PQ_Compiler* c, bool negative)
 {
 	PQ_Token number = eat_token(c);
 
 	Scratch scratch = scratch_make(c->arena);
 
-	PQ_Value imm = pq_value_number(str_as_number(str_copy_from_to(scratch.arena, c->source, number.start, number.end)));
+	String text = str_copy_from_to(scratch.arena, c->source, number.start, number.end);
+
+	// literals without a fractional part are ints, as long as they fit
+	int32_t i = 0;
+
+	PQ_Value imm = {};
+
+	if (str_as_int(text, &i))
+	{
+		imm = pq_value_int(negative ? -i : i);
+	}
+	else
+	{
+		imm = pq_value_number(negative ? -str_as_number(text) : str_as_number(text));
+	}
 
 	scratch_release(scratch);
 
@@ -735,7 +960,10 @@ static void emit_procedure_expression(PQ_Compiler* c)
 
 	String name = str_copy_from_to(c->arena, c->source, ident.start, ident.end);
 
-	if (!procedure_exists(c, name))
+	PQ_InstructionType intrinsic = INST_CALL;
+	bool is_intrinsic = get_intrinsic(c, name, &intrinsic);
+
+	if (!is_intrinsic && !procedure_exists(c, name))
 	{
 		C_ERROR("Undefined procedure '%.*s'", s_fmt(name));
 	}
@@ -744,6 +972,7 @@ static void emit_procedure_expression(PQ_Compiler* c)
 	eat_token(c);
 
 	uint16_t arg_count = 0; 
+	uint16_t array_arg_count = 0;
 
 	// <expr>, <expr>...
 	while (peek_token(c, 0).type != TOKEN_CLOSE_PAREN)
@@ -758,6 +987,7 @@ static void emit_procedure_expression(PQ_Compiler* c)
 		emit_expression(c);
 
 		arg_count++;
+		array_arg_count += may_be_array(c);
 
 		if (peek_token(c, 0).type != TOKEN_CLOSE_PAREN)
 		{
@@ -772,12 +1002,23 @@ static void emit_procedure_expression(PQ_Compiler* c)
 		}
 	}
 
+	if (is_intrinsic)
+	{
+		if (arg_count != 1)
+		{
+			C_ERROR("Expected 1 argument for procedure '%.*s', got %d", s_fmt(name), arg_count);
+		}
+
+		// )
+		try_eat_token(c, TOKEN_CLOSE_PAREN);
+
+		push_inst(c, (PQ_Instruction){ intrinsic });
+		return;
+	}
+
 	PQ_Procedure* proc = get_or_create_procedure(c, name);
 
-	//if (proc->foreign)
-	//{
-	//	proc->used = true;
-	//}
+	proc->used = true;
 
 	if (proc->arg_count != arg_count)
 	{
@@ -787,6 +1028,13 @@ static void emit_procedure_expression(PQ_Compiler* c)
 	// )
 	try_eat_token(c, TOKEN_CLOSE_PAREN);
 
+	// the callee may keep the arrays it's given. foreign ones only by writing one 
+	// into another (e.g. array_fill), the one being compiled isn't known yet.
+	if (proc->foreign ? array_arg_count > 1 : array_arg_count > 0 && (proc->stores_arrays || proc == c->current_proc))
+	{
+		escape_scopes(c, -1);
+	}
+
 	// call the procedure
 	push_inst(c, (PQ_Instruction){ INST_CALL, proc->idx });
 }
@@ -817,20 +1065,27 @@ static void emit_assign_expression(PQ_Compiler* c)
 
 	emit_expression(c);
 
+	if (assign.type == TOKEN_EQUALS && !var->is_int && may_be_array(c))
+	{
+		store_array(c, var);
+	}
+
+	const bool ints = var->is_int && is_int(c);
+
 	switch (assign.type)
 	{
 		case TOKEN_EQUALS: break;
 
-		case TOKEN_PLUS_EQUALS:    push_inst(c, (PQ_Instruction){ INST_ADD }); break;
-		case TOKEN_DASH_EQUALS:    push_inst(c, (PQ_Instruction){ INST_SUB }); break;
+		case TOKEN_PLUS_EQUALS:    push_inst(c, (PQ_Instruction){ int_inst(INST_ADD, ints) }); break;
+		case TOKEN_DASH_EQUALS:    push_inst(c, (PQ_Instruction){ int_inst(INST_SUB, ints) }); break;
 		case TOKEN_SLASH_EQUALS:   push_inst(c, (PQ_Instruction){ INST_DIV }); break;
-		case TOKEN_STAR_EQUALS:    push_inst(c, (PQ_Instruction){ INST_MUL }); break;
-		case TOKEN_PERCENT_EQUALS: push_inst(c, (PQ_Instruction){ INST_MOD }); break;
+		case TOKEN_STAR_EQUALS:    push_inst(c, (PQ_Instruction){ int_inst(INST_MUL, ints) }); break;
+		case TOKEN_PERCENT_EQUALS: push_inst(c, (PQ_Instruction){ int_inst(INST_MOD, ints) }); break;
 
 		default: C_ERROR("Unexpected %s", pq_token_to_c_str(assign.type)); break;
 	}
 
-	push_inst(c, (PQ_Instruction){ var->global ? INST_STORE_GLOBAL : INST_STORE_LOCAL, var->idx });
+	push_inst(c, (PQ_Instruction){ store_inst(c, var), var->idx });
 }
 
 // <expr> <op> <expr>
@@ -844,30 +1099,34 @@ static void emit_binary_expression(PQ_Compiler* c, int8_t min_precedence)
 		emit_expression(c);
 	}
 
+	const bool left_int = is_int(c);
+
 	// <op>
 	PQ_Token op = eat_token(c);
 
 	// right <expr>
 	emit_expression(c);
 
+	const bool ints = left_int && is_int(c);
+
 	switch (op.type)
 	{
-		case TOKEN_PERCENT:       push_inst(c, (PQ_Instruction){ INST_MOD }); break; 
-		case TOKEN_PLUS:          push_inst(c, (PQ_Instruction){ INST_ADD }); break; 
-		case TOKEN_DASH:          push_inst(c, (PQ_Instruction){ INST_SUB }); break;
+		case TOKEN_PERCENT:       push_inst(c, (PQ_Instruction){ int_inst(INST_MOD, ints) }); break; 
+		case TOKEN_PLUS:          push_inst(c, (PQ_Instruction){ int_inst(INST_ADD, ints) }); break; 
+		case TOKEN_DASH:          push_inst(c, (PQ_Instruction){ int_inst(INST_SUB, ints) }); break;
 		case TOKEN_SLASH:         push_inst(c, (PQ_Instruction){ INST_DIV }); break; 
-		case TOKEN_STAR:          push_inst(c, (PQ_Instruction){ INST_MUL }); break; 
+		case TOKEN_STAR:          push_inst(c, (PQ_Instruction){ int_inst(INST_MUL, ints) }); break; 
 
 		case TOKEN_LEFT_SHIFT:    push_inst(c, (PQ_Instruction){ INST_BW_LEFT_SHIFT }); break;  
 		case TOKEN_RIGHT_SHIFT:   push_inst(c, (PQ_Instruction){ INST_BW_RIGHT_SHIFT }); break;  
 
-		case TOKEN_LESS:          push_inst(c, (PQ_Instruction){ INST_LESS }); break; 
-		case TOKEN_GREATER:       push_inst(c, (PQ_Instruction){ INST_GREATER }); break; 
-		case TOKEN_LESS_THAN:     push_inst(c, (PQ_Instruction){ INST_LESS_THAN }); break; 
-		case TOKEN_GREATER_THAN:  push_inst(c, (PQ_Instruction){ INST_GREATER_THAN }); break; 
+		case TOKEN_LESS:          push_inst(c, (PQ_Instruction){ int_inst(INST_LESS, ints) }); break; 
+		case TOKEN_GREATER:       push_inst(c, (PQ_Instruction){ int_inst(INST_GREATER, ints) }); break; 
+		case TOKEN_LESS_THAN:     push_inst(c, (PQ_Instruction){ int_inst(INST_LESS_THAN, ints) }); break; 
+		case TOKEN_GREATER_THAN:  push_inst(c, (PQ_Instruction){ int_inst(INST_GREATER_THAN, ints) }); break; 
 		
-		case TOKEN_DOUBLE_EQUALS: push_inst(c, (PQ_Instruction){ INST_EQUALS }); break;
-		case TOKEN_NOT_EQUALS:    push_inst(c, (PQ_Instruction){ INST_EQUALS }); push_inst(c, (PQ_Instruction){ INST_NOT }); break; 
+		case TOKEN_DOUBLE_EQUALS: push_inst(c, (PQ_Instruction){ int_inst(INST_EQUALS, ints) }); break;
+		case TOKEN_NOT_EQUALS:    push_inst(c, (PQ_Instruction){ int_inst(INST_EQUALS, ints) }); push_inst(c, (PQ_Instruction){ INST_NOT }); break; 
 		
 		case TOKEN_PIPE:          push_inst(c, (PQ_Instruction){ INST_BW_OR }); break;
 		case TOKEN_CARET:         push_inst(c, (PQ_Instruction){ INST_BW_XOR }); break;
@@ -893,7 +1152,8 @@ static void emit_string_expression(PQ_Compiler* c)
 {
 	PQ_Token str = eat_token(c);
 
-	String s = str_copy_from_to(c->arena, c->source, str.start, str.end);
+	// without the quotes
+	String s = str_copy_from_to(c->arena, c->source, str.start + 1, str.end - 1);
 
 	// unescape string
 	for (size_t i = 0; i < s.length; i++)
@@ -922,6 +1182,30 @@ static void emit_string_expression(PQ_Compiler* c)
 	push_inst(c, (PQ_Instruction){ INST_LOAD_IMMEDIATE, get_or_create_immediate(c, imm) });
 }
 
+// packed arrays get subscripts of their own element type, which only fall back 
+// to the generic ones if the variable ends up holding anything else
+static PQ_InstructionType load_subscript_inst(const PQ_Variable* var)
+{
+	switch (var->array_type)
+	{
+		case VALUE_INT_ARRAY:    return var->global ? INST_LOAD_GLOBAL_INT_SUBSCRIPT : INST_LOAD_LOCAL_INT_SUBSCRIPT;
+		case VALUE_NUMBER_ARRAY: return var->global ? INST_LOAD_GLOBAL_NUMBER_SUBSCRIPT : INST_LOAD_LOCAL_NUMBER_SUBSCRIPT;
+
+		default: return var->global ? INST_LOAD_GLOBAL_SUBSCRIPT : INST_LOAD_LOCAL_SUBSCRIPT;
+	}
+}
+
+static PQ_InstructionType store_subscript_inst(const PQ_Variable* var)
+{
+	switch (var->array_type)
+	{
+		case VALUE_INT_ARRAY:    return var->global ? INST_STORE_GLOBAL_INT_SUBSCRIPT : INST_STORE_LOCAL_INT_SUBSCRIPT;
+		case VALUE_NUMBER_ARRAY: return var->global ? INST_STORE_GLOBAL_NUMBER_SUBSCRIPT : INST_STORE_LOCAL_NUMBER_SUBSCRIPT;
+
+		default: return var->global ? INST_STORE_GLOBAL_SUBSCRIPT : INST_STORE_LOCAL_SUBSCRIPT;
+	}
+}
+
 // <ident>[<expr>] 
 // OR
 // <ident>[<expr>] = <expr>
@@ -952,7 +1236,7 @@ static void emit_array_element_expression(PQ_Compiler* c)
 	// ]
 	try_eat_token(c, TOKEN_CLOSE_BOX);
 
-	push_inst(c, (PQ_Instruction){ var->global ? INST_LOAD_GLOBAL_SUBSCRIPT : INST_LOAD_LOCAL_SUBSCRIPT, var->idx });	
+	push_inst(c, (PQ_Instruction){ load_subscript_inst(var), var->idx });	
 
 	// ..=..
 	if (pq_token_is_assign_op(peek_token(c, 0).type))
@@ -988,6 +1272,11 @@ static void emit_array_element_expression(PQ_Compiler* c)
 			default: C_ERROR("Unexpected %s", pq_token_to_c_str(assign.type)); break;
 		}
 
+		if (may_be_array(c))
+		{
+			store_array_element(c, var);
+		}
+
 		uint16_t current_pos = c->idx;
 
 		// jump back to the start and read out the subscript
@@ -1005,7 +1294,7 @@ static void emit_array_element_expression(PQ_Compiler* c)
 		// ...go back where we left off
 		c->idx = current_pos;
 
-		push_inst(c, (PQ_Instruction){ var->global ? INST_STORE_GLOBAL_SUBSCRIPT : INST_STORE_LOCAL_SUBSCRIPT, var->idx });
+		push_inst(c, (PQ_Instruction){ store_subscript_inst(var), var->idx });
 	}
 }
 
@@ -1023,8 +1312,16 @@ static void emit_expression(PQ_Compiler* c)
 		case TOKEN_DASH:
 		{
 			eat_token(c);
-			emit_expression(c);
-			push_inst(c, (PQ_Instruction){ INST_NEGATE });
+
+			if (peek_token(c, 0).type == TOKEN_NUMBER && !pq_token_is_binary_op(peek_token(c, 1).type))
+			{
+				emit_number_expression(c, true);
+			}
+			else
+			{
+				emit_expression(c);
+				push_inst(c, (PQ_Instruction){ INST_NEGATE });
+			}
 		} break;
 
 		case TOKEN_OPEN_PAREN:
@@ -1036,7 +1333,7 @@ static void emit_expression(PQ_Compiler* c)
 
 		case TOKEN_NUMBER:
 		{
-			emit_number_expression(c);
+			emit_number_expression(c, false);
 		} break;
 
 		case TOKEN_STRING:
@@ -1093,11 +1390,42 @@ static void begin_scope(PQ_Compiler* c, PQ_Scope* scope)
 
 	scope->previous = c->current_scope;
 
+	scope->depth = scope->previous ? scope->previous->depth + scope->previous->reclaim : 0;
+
 	c->current_scope = scope;
+
+	if (scope->reclaim)
+	{
+		push_inst(c, (PQ_Instruction){ INST_ENTER_SCOPE, scope->depth });
+	}
+}
+
+// the markers of a scope that escapes were emitted before that was known. 
+// they become jumps to the next instruction, its arrays go to the scope around it.
+static void keep_scope_arrays(PQ_Compiler* c, const PQ_Scope* scope)
+{
+	for (uint16_t i = scope->first_inst; i < c->instruction_count; i++)
+	{
+		PQ_Instruction* it = &c->instructions[i];
+
+		if ((it->type == INST_ENTER_SCOPE || it->type == INST_LEAVE_SCOPE) && it->arg == scope->depth)
+		{
+			*it = (PQ_Instruction){ INST_JUMP, i + 1 };
+		}
+	}
 }
 
 static void end_scope(PQ_Compiler* c, PQ_Scope* scope) 
 {
+	if (scope->reclaim && scope->escapes)
+	{
+		keep_scope_arrays(c, scope);
+	}
+	else if (scope->reclaim)
+	{
+		push_inst(c, (PQ_Instruction){ INST_LEAVE_SCOPE, scope->depth });
+	}
+
 	scope->last_inst = c->instruction_count;
 
 	c->current_scope = scope->previous;
@@ -1127,11 +1455,26 @@ static void emit_scope(PQ_Compiler* c)
 // statements
 //
 
+static PQ_InstructionType array_load_inst(const PQ_Variable* var)
+{
+	switch (var->array_type)
+	{
+		case VALUE_INT_ARRAY:    return INST_LOAD_INT_ARRAY;
+		case VALUE_NUMBER_ARRAY: return INST_LOAD_NUMBER_ARRAY;
+
+		default: return INST_LOAD_ARRAY;
+	}
+}
+
 // var <ident> 
 // OR 
 // var <ident> = <expr>
 // OR
 // var <ident>[N] | var <ident>[] = { ... } | var <ident>[N] = { ... }
+// OR
+// any of the array forms with a packed element type, var <ident>[N]: int | number
+// OR
+// var <ident>: int | var <ident>: int = <expr>
 static void emit_var_statement(PQ_Compiler* c)
 {
 	// var
@@ -1160,6 +1503,7 @@ static void emit_var_statement(PQ_Compiler* c)
 		eat_token(c);
 
 		var->array = true;
+		var->array_type = VALUE_ARRAY;
 
 		// unknown size
 		if (peek_token(c, 0).type == TOKEN_CLOSE_BOX)
@@ -1191,6 +1535,53 @@ static void emit_var_statement(PQ_Compiler* c)
 
 		// ]
 		try_eat_token(c, TOKEN_CLOSE_BOX);
+
+		// : int | number
+		if (peek_token(c, 0).type == TOKEN_COLON)
+		{
+			eat_token(c);
+
+			PQ_Token kind = try_eat_token(c, TOKEN_IDENTIFIER);
+
+			Scratch scratch = scratch_make(c->arena);
+
+			String kind_name = str_copy_from_to(scratch.arena, c->source, kind.start, kind.end);
+
+			if (str_equals(kind_name, s("int")))
+			{
+				var->array_type = VALUE_INT_ARRAY;
+			}
+			else if (str_equals(kind_name, s("number")))
+			{
+				var->array_type = VALUE_NUMBER_ARRAY;
+			}
+			else
+			{
+				C_ERROR("Expected `int` or `number` as array element type, got '%.*s'", s_fmt(kind_name));
+			}
+
+			scratch_release(scratch);
+		}
+	}
+	// : int
+	else if (peek_token(c, 0).type == TOKEN_COLON)
+	{
+		eat_token(c);
+
+		PQ_Token kind = try_eat_token(c, TOKEN_IDENTIFIER);
+
+		Scratch scratch = scratch_make(c->arena);
+
+		String kind_name = str_copy_from_to(scratch.arena, c->source, kind.start, kind.end);
+
+		if (!str_equals(kind_name, s("int")))
+		{
+			C_ERROR("Expected `int` as variable type, got '%.*s'", s_fmt(kind_name));
+		}
+
+		scratch_release(scratch);
+
+		var->is_int = true;
 	}
 
 	// =
@@ -1201,7 +1592,7 @@ static void emit_var_statement(PQ_Compiler* c)
 		// initializer list
 		if (var->array)
 		{
-			PQ_Instruction* load_array = push_inst(c, (PQ_Instruction){ INST_LOAD_ARRAY });
+			PQ_Instruction* load_array = push_inst(c, (PQ_Instruction){ array_load_inst(var) });
 			push_inst(c, (PQ_Instruction){ var->global ? INST_STORE_GLOBAL : INST_STORE_LOCAL, var->idx });
 
 			uint16_t size = 0;
@@ -1221,9 +1612,14 @@ static void emit_var_statement(PQ_Compiler* c)
 				// <expr>
 				emit_expression(c);
 
-				push_inst(c, (PQ_Instruction){ INST_LOAD_IMMEDIATE, get_or_create_immediate(c, pq_value_number(size++)) });
+				if (may_be_array(c))
+				{
+					store_array_element(c, var);
+				}
+
+				push_inst(c, (PQ_Instruction){ INST_LOAD_IMMEDIATE, get_or_create_immediate(c, pq_value_int(size++)) });
 
-				push_inst(c, (PQ_Instruction){ var->global ? INST_STORE_GLOBAL_SUBSCRIPT : INST_STORE_LOCAL_SUBSCRIPT, var->idx });
+				push_inst(c, (PQ_Instruction){ store_subscript_inst(var), var->idx });
 
 				if (peek_token(c, 0).type != TOKEN_CLOSE_BRACE)
 				{
@@ -1256,12 +1652,25 @@ static void emit_var_statement(PQ_Compiler* c)
 			}
 
 			load_array->arg = var->array_size;
+
+			// a full initializer list that can't see the array doesn't need it cleared first
+			uint16_t first = (uint16_t)(load_array - c->instructions) + 2;
+
+			if (var->array_type == VALUE_ARRAY && size == var->array_size && !variable_read(c, var, first, c->instruction_count))
+			{
+				load_array->type = INST_LOAD_ARRAY_UNINIT;
+			}
 		}
 		else
 		{
 			emit_expression(c);
 
-			push_inst(c, (PQ_Instruction){ var->global ? INST_STORE_GLOBAL : INST_STORE_LOCAL, var->idx });
+			if (!var->is_int && may_be_array(c))
+			{
+				store_array(c, var);
+			}
+
+			push_inst(c, (PQ_Instruction){ store_inst(c, var), var->idx });
 		}
 	}
 	// declaration
@@ -1275,7 +1684,13 @@ static void emit_var_statement(PQ_Compiler* c)
 				C_ERROR("Declaration of unknown size array is not allowed");
 			}
 
-			push_inst(c, (PQ_Instruction){ INST_LOAD_ARRAY, var->array_size });
+			push_inst(c, (PQ_Instruction){ array_load_inst(var), var->array_size });
+			push_inst(c, (PQ_Instruction){ var->global ? INST_STORE_GLOBAL : INST_STORE_LOCAL, var->idx });
+		}
+		// int variable, starts at 0
+		else if (var->is_int)
+		{
+			push_inst(c, (PQ_Instruction){ INST_LOAD_IMMEDIATE, get_or_create_immediate(c, pq_value_int(0)) });
 			push_inst(c, (PQ_Instruction){ var->global ? INST_STORE_GLOBAL : INST_STORE_LOCAL, var->idx });
 		}
 		// simple variable
@@ -1346,6 +1761,9 @@ static void emit_define_statement(PQ_Compiler* c)
 
 		PQ_Variable* var = get_or_create_variable(c, name);
 
+		// arguments hold the arrays of the caller
+		var->borrows = true;
+
 		proc->arg_count++;
 
 		if (peek_token(c, 0).type != TOKEN_CLOSE_PAREN)
@@ -1364,6 +1782,17 @@ static void emit_define_statement(PQ_Compiler* c)
 	// )
 	try_eat_token(c, TOKEN_CLOSE_PAREN);
 
+	// called by the host every frame, see PQ_ProcedureFlags
+	if (str_equals(name, s("update")) && proc->arg_count != 1)
+	{
+		C_ERROR("Procedure `update` takes a single argument, the time since the last frame");
+	}
+
+	if (str_equals(name, s("draw")) && proc->arg_count != 0)
+	{
+		C_ERROR("Procedure `draw` takes no arguments");
+	}
+
 	// {
 	try_eat_token(c, TOKEN_OPEN_BRACE);
 
@@ -1441,8 +1870,13 @@ static void emit_repeat_statement(PQ_Compiler* c)
 	// <expr>
 	emit_expression(c);
 
+	// an int count can be counted down with the int opcodes, it never overflows
+	const bool ints = is_int(c);
+
 	PQ_Loop loop = {};
 
+	loop.scope.reclaim = true;
+
 	String name = str_format(c->arena, "__repeat_var_%d", c->instruction_count);
 
 	PQ_Variable* var = get_or_create_variable(c, name);
@@ -1462,16 +1896,16 @@ static void emit_repeat_statement(PQ_Compiler* c)
 
 	// repeat_local >= 0
 	push_inst(c, (PQ_Instruction){ var->global ? INST_LOAD_GLOBAL : INST_LOAD_LOCAL, var->idx });
-	push_inst(c, (PQ_Instruction){ INST_LOAD_IMMEDIATE, get_or_create_immediate(c, pq_value_number(0.0f)) });
-	push_inst(c, (PQ_Instruction){ INST_LESS_THAN });
+	push_inst(c, (PQ_Instruction){ INST_LOAD_IMMEDIATE, get_or_create_immediate(c, pq_value_int(0)) });
+	push_inst(c, (PQ_Instruction){ int_inst(INST_LESS_THAN, ints) });
 
 	// true? skip the loop
 	PQ_Instruction* jump_cond = push_inst(c, (PQ_Instruction){ INST_JUMP_COND });
 
 	// repeat_local = repeat_local - 1
 	push_inst(c, (PQ_Instruction){ var->global ? INST_LOAD_GLOBAL : INST_LOAD_LOCAL, var->idx });
-	push_inst(c, (PQ_Instruction){ INST_LOAD_IMMEDIATE, get_or_create_immediate(c, pq_value_number(1.0f)) });
-	push_inst(c, (PQ_Instruction){ INST_SUB });
+	push_inst(c, (PQ_Instruction){ INST_LOAD_IMMEDIATE, get_or_create_immediate(c, pq_value_int(1)) });
+	push_inst(c, (PQ_Instruction){ int_inst(INST_SUB, ints) });
 	push_inst(c, (PQ_Instruction){ var->global ? INST_STORE_GLOBAL : INST_STORE_LOCAL, var->idx });
 
 	c->current_loop = &loop;
@@ -1486,11 +1920,11 @@ static void emit_repeat_statement(PQ_Compiler* c)
 	// }
 	try_eat_token(c, TOKEN_CLOSE_BRACE);
 
-	push_inst(c, (PQ_Instruction){ INST_JUMP, loop.scope.first_inst });
-	
 	end_scope(c, &loop.scope);
 
-	jump_cond->arg = loop.scope.last_inst;
+	push_inst(c, (PQ_Instruction){ INST_JUMP, loop.scope.first_inst });
+
+	jump_cond->arg = loop.scope.last_inst + 1; // last statement + the jump
 
 	// patch breaks
 	patch_breaks(c, &loop);
@@ -1507,6 +1941,8 @@ static void emit_repeat_until_statement(PQ_Compiler* c)
 
 	PQ_Loop loop = {};
 
+	loop.scope.reclaim = true;
+
 	begin_scope(c, &loop.scope);
 
 	// <expr>
@@ -1547,6 +1983,8 @@ static void emit_forever_statement(PQ_Compiler* c)
 
 	PQ_Loop loop = {};
 
+	loop.scope.reclaim = true;
+
 	begin_scope(c, &loop.scope);
 	
 	// {
@@ -1729,6 +2167,9 @@ static void emit_break_statement(PQ_Compiler* c)
 	// break
 	eat_token(c);
 
+	// release the arrays of the loop body, since its end is skipped
+	push_inst(c, (PQ_Instruction){ INST_LEAVE_SCOPE, c->current_loop->scope.depth });
+
 	// argument is -1 so we know what instructions to patch in the loop statements.
 	push_inst(c, (PQ_Instruction){ INST_JUMP, (uint16_t)-1 });
 }
@@ -1911,24 +2352,37 @@ void pq_compiler_init(PQ_Compiler* c, Arena* arena, String source, PQ_CompilerEr
 
 	c->error = error;
 
-	c->tokens = arena_push_array(c->arena, PQ_Token, PQ_MAX_TOKENS);
+	// tables are only ever read up to their count, entries get fully written when pushed
+	ArenaTag tag = arena_set_tag(c->arena, ARENA_TAG_TOKENS);
+
+	c->tokens = arena_push_array_uninit(c->arena, PQ_Token, PQ_MAX_TOKENS);
 	c->token_count = 0;
 
-	c->instructions = arena_push_array(c->arena, PQ_Instruction, PQ_MAX_INSTRUCTIONS);
+	arena_set_tag(c->arena, ARENA_TAG_INSTRUCTIONS);
+
+	c->instructions = arena_push_array_uninit(c->arena, PQ_Instruction, PQ_MAX_INSTRUCTIONS);
+	c->instruction_lines = arena_push_array_uninit(c->arena, uint16_t, PQ_MAX_INSTRUCTIONS);
 	c->instruction_count = 0;
 
-	c->immediates = arena_push_array(c->arena, PQ_Value, PQ_MAX_IMMEDIATES);
+	c->debug_info = false;
+
+	arena_set_tag(c->arena, ARENA_TAG_SYMBOLS);
+
+	c->immediates = arena_push_array_uninit(c->arena, PQ_Value, PQ_MAX_IMMEDIATES);
 	c->immediate_count = 0;
 
-	c->procedures = arena_push_array(c->arena, PQ_Procedure, PQ_MAX_PROCEDURES);
+	c->procedures = arena_push_array_uninit(c->arena, PQ_Procedure, PQ_MAX_PROCEDURES);
 	c->procedure_count = 0;
+	c->registry_version = 0;
 
-	c->locals = arena_push_array(c->arena, PQ_Variable, PQ_MAX_LOCALS);
+	c->locals = arena_push_array_uninit(c->arena, PQ_Variable, PQ_MAX_LOCALS);
 	c->local_count = 0;
 
-	c->globals = arena_push_array(c->arena, PQ_Variable, PQ_MAX_GLOBALS);
+	c->globals = arena_push_array_uninit(c->arena, PQ_Variable, PQ_MAX_GLOBALS);
 	c->global_count = 0;
 
+	arena_set_tag(c->arena, tag);
+
 	c->current_scope = nullptr;
 	c->current_proc = nullptr;
 	c->current_loop = nullptr;
@@ -1943,7 +2397,12 @@ void pq_compiler_init(PQ_Compiler* c, Arena* arena, String source, PQ_CompilerEr
 
 static void write_to_blob(void* v, PQ_CompiledBlob* b, size_t type_size)
 {
-	__builtin_memcpy(b->buffer + b->size, v, type_size);
+	// keep counting past the end, so pq_compile can tell how big the program is
+	if (b->size + type_size <= PQ_MAX_BLOB_SIZE + PQ_MAX_DEBUG_INFO_SIZE)
+	{
+		__builtin_memcpy(b->buffer + b->size, v, type_size);
+	}
+
 	b->size += type_size;
 }
 
@@ -1967,7 +2426,14 @@ static void write_immediates(PQ_Compiler* c, PQ_CompiledBlob* b)
 		{
 			case VALUE_NULL: break;
 
-			case VALUE_NUMBER:  write_to_blob(&v.n, b, sizeof(float)); break;
+			// always a float, blobs don't depend on the number type the vm is built with
+			case VALUE_NUMBER:
+			{
+				float n = pq_number_to_float(v.n);
+				write_to_blob(&n, b, sizeof(float));
+			} break;
+
+			case VALUE_INT:     write_to_blob(&v.i, b, sizeof(int32_t)); break;
 			case VALUE_BOOLEAN: write_to_blob(&v.b, b, sizeof(bool)); break;
 
 			case VALUE_STRING:
@@ -1987,34 +2453,65 @@ static void write_immediates(PQ_Compiler* c, PQ_CompiledBlob* b)
 	}
 }
 
+// foreign procedures are written as their ordinal in the registry, or the 
+// hash of their name when they're not in it. unused ones are left out.
+// each one starts with its PQ_ProcedureFlags.
 static void write_procedures(PQ_Compiler* c, PQ_CompiledBlob* b)
 {
-	write_to_blob(&c->procedure_count, b, sizeof(uint16_t));
+	write_to_blob(&c->registry_version, b, sizeof(uint16_t));
+
+	uint16_t count = 0;
+
+	for (uint16_t i = 0; i < c->procedure_count; i++)
+	{
+		PQ_Procedure* p = &c->procedures[i];
+
+		if (!p->foreign || p->used)
+		{
+			p->blob_idx = count++;
+		}
+	}
+
+	write_to_blob(&count, b, sizeof(uint16_t));
 
 	for (uint16_t i = 0; i < c->procedure_count; i++)
 	{
 		PQ_Procedure p = c->procedures[i];
 	
-		//if (!p.used)
-		//{
-		//	continue;
-		//}
+		if (p.foreign && !p.used)
+		{
+			continue;
+		}
+
+		uint8_t flags = p.foreign ? PQ_PROCEDURE_FOREIGN : 0;
 
-		write_to_blob(&p.foreign, b, sizeof(bool));
-		write_to_blob(&p.local_count, b, sizeof(uint16_t));
+		if (!p.foreign && str_equals(p.name, s("update")))
+		{
+			flags |= PQ_PROCEDURE_UPDATE;
+		}
+
+		if (!p.foreign && str_equals(p.name, s("draw")))
+		{
+			flags |= PQ_PROCEDURE_DRAW;
+		}
+
+		write_to_blob(&flags, b, sizeof(uint8_t));
 		write_to_blob(&p.arg_count, b, sizeof(uint16_t));
-		write_to_blob(&p.scope.first_inst, b, sizeof(uint16_t));
 	
 		if (p.foreign)
 		{
-			for (size_t i = 0; i < p.name.length; i++)
+			write_to_blob(&p.ordinal, b, sizeof(uint16_t));
+
+			if (p.ordinal == PQ_FOREIGN_UNREGISTERED)
 			{
-				write_to_blob(&p.name.buffer[i], b, sizeof(char));
+				uint32_t hash = pq_foreign_hash(p.name);
+				write_to_blob(&hash, b, sizeof(uint32_t));
 			}
-
-			char n = '\0';
-
-			write_to_blob(&n, b, sizeof(char));
+		}
+		else
+		{
+			write_to_blob(&p.local_count, b, sizeof(uint16_t));
+			write_to_blob(&p.scope.first_inst, b, sizeof(uint16_t));
 		}
 	}
 }
@@ -2037,6 +2534,11 @@ static void write_instructions(PQ_Compiler* c, PQ_CompiledBlob* b)
 	{
 		PQ_Instruction it = c->instructions[i];
 
+		if (it.type == INST_CALL)
+		{
+			it.arg = c->procedures[it.arg].blob_idx;
+		}
+
 		write_to_blob(&it.type, b, sizeof(PQ_InstructionType));
 
 		if (pq_inst_needs_arg(it.type))
@@ -2046,7 +2548,58 @@ static void write_instructions(PQ_Compiler* c, PQ_CompiledBlob* b)
 	}
 }
 
-static void write_blob(PQ_Compiler* c, PQ_CompiledBlob* b)
+// the names of the procedures in the blob, in its order, and when they end.
+// lines are run length encoded, as (first instruction, line) where they change.
+static void write_debug_info(PQ_Compiler* c, PQ_CompiledBlob* b)
+{
+	uint32_t magic = __builtin_bswap32(PQ_DEBUG_INFO_MAGIC);
+	write_to_blob(&magic, b, sizeof(uint32_t));
+
+	for (uint16_t i = 0; i < c->procedure_count; i++)
+	{
+		PQ_Procedure p = c->procedures[i];
+
+		if (p.foreign && !p.used)
+		{
+			continue;
+		}
+
+		uint8_t length = (uint8_t)MIN(p.name.length, (size_t)UINT8_MAX);
+
+		write_to_blob(&length, b, sizeof(uint8_t));
+
+		for (uint8_t j = 0; j < length; j++)
+		{
+			write_to_blob(&p.name.buffer[j], b, sizeof(char));
+		}
+
+		if (!p.foreign)
+		{
+			write_to_blob(&p.scope.last_inst, b, sizeof(uint16_t));
+		}
+	}
+
+	uint16_t run_count = 0;
+
+	for (uint16_t i = 0; i < c->instruction_count; i++)
+	{
+		run_count += i == 0 || c->instruction_lines[i] != c->instruction_lines[i - 1];
+	}
+
+	write_to_blob(&run_count, b, sizeof(uint16_t));
+
+	for (uint16_t i = 0; i < c->instruction_count; i++)
+	{
+		if (i == 0 || c->instruction_lines[i] != c->instruction_lines[i - 1])
+		{
+			write_to_blob(&i, b, sizeof(uint16_t));
+			write_to_blob(&c->instruction_lines[i], b, sizeof(uint16_t));
+		}
+	}
+}
+
+// returns the size of the program, without its debug info
+static uint16_t write_blob(PQ_Compiler* c, PQ_CompiledBlob* b)
 {
 	write_magic(c, b);
 	write_immediates(c, b);
@@ -2054,19 +2607,49 @@ static void write_blob(PQ_Compiler* c, PQ_CompiledBlob* b)
 	write_global_count(c, b);
 	write_local_count(c, b);
 	write_instructions(c, b);
+
+	const uint16_t program_size = b->size;
+
+	if (c->debug_info)
+	{
+		write_debug_info(c, b);
+	}
+
+	return program_size;
 }
 
 PQ_CompiledBlob pq_compile(PQ_Compiler* c)
 {
+	PQ_TRACE_BEGIN(s("tokenize"));
 	tokenize(c);
+	PQ_TRACE_END(s("tokenize"));
+
+	PQ_TRACE_BEGIN(s("generate"));
 	generate(c);
+	PQ_TRACE_END(s("generate"));
 
 	PQ_CompiledBlob b = {};
 
-	b.buffer = arena_push_array(c->arena, uint8_t, PQ_MAX_BLOB_SIZE);
+	ArenaTag tag = arena_set_tag(c->arena, ARENA_TAG_BLOB);
+
+	b.buffer = arena_push_array_uninit(c->arena, uint8_t, PQ_MAX_BLOB_SIZE + PQ_MAX_DEBUG_INFO_SIZE);
 	b.size = 0;	
 
-	write_blob(c, &b);
+	arena_set_tag(c->arena, tag);
+
+	PQ_TRACE_BEGIN(s("write_blob"));
+	const uint16_t program_size = write_blob(c, &b);
+	PQ_TRACE_END(s("write_blob"));
+
+	if (program_size > PQ_MAX_BLOB_SIZE)
+	{
+		C_ERROR("Program is too big, it takes %d bytes out of %d", (int)program_size, PQ_MAX_BLOB_SIZE);
+	}
+
+	if (b.size - program_size > PQ_MAX_DEBUG_INFO_SIZE)
+	{
+		C_ERROR("Debug info is too big, it takes %d bytes out of %d", b.size - program_size, PQ_MAX_DEBUG_INFO_SIZE);
+	}
 
 	return b;
 }
@@ -2084,4 +2667,16 @@ void pq_compiler_declare_foreign_proc(PQ_Compiler* c, String name, uint16_t arg_
 	proc->arg_count = arg_count;
 }
 
+void pq_compiler_declare_foreign_registry(PQ_Compiler* c, const PQ_ForeignRegistry* registry)
+{
+	c->registry_version = registry->version;
+
+	for (uint16_t i = 0; i < registry->proc_count; i++)
+	{
+		pq_compiler_declare_foreign_proc(c, registry->procs[i].name, registry->procs[i].arg_count);
+
+		c->procedures[c->procedure_count - 1].ordinal = i;
+	}
+}
+
 #undef C_ERROR
\ No newline at end of file
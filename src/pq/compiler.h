@@ -12,6 +12,14 @@ struct PQ_Scope
 	uint16_t last_inst;
 	uint16_t local_base;
 
+	// scopes that may be entered over and over (loop bodies) release the arrays 
+	// allocated in them upon leaving. `depth` is the amount of such scopes around 
+	// this one, within the procedure. one that may store an array somewhere that 
+	// outlives it `escapes`, and keeps its arrays after all.
+	bool reclaim;
+	bool escapes;
+	uint16_t depth;
+
 	PQ_Scope* previous; 
 };
 
@@ -27,6 +35,15 @@ struct PQ_Procedure
 	bool used;
 	bool foreign;
 
+	// may store an array into a global or an array element, see PQ_Scope.escapes
+	bool stores_arrays;
+
+	// position in the registry, PQ_FOREIGN_UNREGISTERED otherwise
+	uint16_t ordinal;
+
+	// unused foreign procedures are left out of the blob, so indices shift
+	uint16_t blob_idx;
+
 	PQ_Scope scope;
 };
 
@@ -40,6 +57,17 @@ struct PQ_Variable
 
 	bool array;
 	uint16_t array_size;
+
+	// VALUE_ARRAY, or one of the packed kinds for `var <ident>[N]: int`
+	PQ_ValueType array_type;
+
+	// declared `var <ident>: int`, it only ever holds ints
+	bool is_int;
+
+	// whether it may hold an array it didn't allocate (arguments, assignments),
+	// and whether arrays were stored in its elements. see PQ_Scope.escapes
+	bool borrows;
+	bool holds_arrays;
 };
 
 typedef struct PQ_Loop PQ_Loop;
@@ -65,11 +93,20 @@ struct PQ_Compiler
 	PQ_Instruction* instructions;
 	uint16_t instruction_count;
 
+	// the source line of every instruction
+	uint16_t* instruction_lines;
+
+	// set before pq_compile to append debug info (procedure names and the line
+	// of every instruction) to the blob. it doesn't count towards PQ_MAX_BLOB_SIZE,
+	// but makes the blob too big to share.
+	bool debug_info;
+
 	PQ_Value* immediates;
 	uint16_t immediate_count;
 
 	PQ_Procedure* procedures;
 	uint16_t procedure_count;
+	uint16_t registry_version;
 
 	PQ_Variable* globals;
 	uint16_t global_count;
@@ -90,4 +127,6 @@ void pq_compiler_init(PQ_Compiler* c, Arena* arena, String source, PQ_CompilerEr
 
 PQ_CompiledBlob pq_compile(PQ_Compiler* c);
 
-void pq_compiler_declare_foreign_proc(PQ_Compiler* c, String name, uint16_t arg_count);
\ No newline at end of file
+void pq_compiler_declare_foreign_proc(PQ_Compiler* c, String name, uint16_t arg_count);
+
+void pq_compiler_declare_foreign_registry(PQ_Compiler* c, const PQ_ForeignRegistry* registry);
\ No newline at end of file
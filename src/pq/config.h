@@ -6,6 +6,9 @@ static constexpr uint16_t PQ_MAX_TOKENS = 1 << 12;
 static constexpr uint16_t PQ_MAX_INSTRUCTIONS = 1 << 12;
 static constexpr uint16_t PQ_MAX_BLOB_SIZE = 2953;
 
+// debug info comes after the program and may take this much more, see PQ_Compiler
+static constexpr uint16_t PQ_MAX_DEBUG_INFO_SIZE = 16 * 1024;
+
 static constexpr uint16_t PQ_MAX_PROCEDURES = 256;
 static constexpr uint16_t PQ_MAX_SCOPES = 256;
 
@@ -14,4 +17,28 @@ static constexpr uint16_t PQ_MAX_GLOBALS = 512;
 
 static constexpr uint16_t PQ_MAX_IMMEDIATES = 256;
 static constexpr uint16_t PQ_MAX_CALL_FRAMES = PQ_MAX_SCOPES;
-static constexpr uint16_t PQ_MAX_STACK_SIZE = 256;
\ No newline at end of file
+static constexpr uint16_t PQ_MAX_STACK_SIZE = 256;
+
+// hosts can trace where the time goes by defining these before including the
+// sources. they get a String naming the span: the compile phases, loading a
+// blob and foreign calls. spans nest. PQ_TRACE_FRAME ends one frame and starts
+// the next, frames don't nest with anything.
+#if !defined PQ_TRACE_BEGIN
+	#define PQ_TRACE_BEGIN(name)
+	#define PQ_TRACE_END(name)
+#endif
+
+#if !defined PQ_TRACE_FRAME
+	#define PQ_TRACE_FRAME(name)
+#endif
+
+// distinct call stacks a profiler tells apart, and how many of their innermost frames it keeps
+static constexpr uint16_t PQ_MAX_PROFILE_STACKS = 1024;
+static constexpr uint16_t PQ_MAX_PROFILE_DEPTH = 32;
+
+// build with PQ_FIXED_POINT to make numbers signed fixed point instead of 
+// float, for targets without an fpu. PQ_FIXED_FRACTION_BITS picks the format, 
+// the default is Q16.16: numbers in [-32768, 32768) with a 1/65536 step.
+#if defined PQ_FIXED_POINT && !defined PQ_FIXED_FRACTION_BITS
+	#define PQ_FIXED_FRACTION_BITS 16
+#endif
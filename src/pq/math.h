@@ -0,0 +1,221 @@
+#pragma once
+
+#include <base/common.h>
+
+#include <pq/types.h>
+#include <pq/config.h>
+
+//
+// math intrinsics
+//
+// backs the math opcodes (see DEFINE_INSTRUCTIONS), PQ_Number in and out.
+// nothing here calls into libm, so on wasm they don't leave the module and
+// with PQ_FIXED_POINT they never touch a float.
+//
+
+#if defined PQ_FIXED_POINT
+	static constexpr int64_t PQ_MATH_PI = (int64_t)(3.14159265358979 * PQ_NUMBER_ONE + 0.5);
+	static constexpr int64_t PQ_MATH_HALF_PI = (int64_t)(1.57079632679490 * PQ_NUMBER_ONE + 0.5);
+
+	static inline PQ_Number pq_math_abs(PQ_Number n)
+	{
+		return pq_number_saturate(n < 0 ? -(int64_t)n : n);
+	}
+
+	static inline PQ_Number pq_math_floor(PQ_Number n)
+	{
+		return n & ~(PQ_NUMBER_ONE - 1);
+	}
+
+	static inline PQ_Number pq_math_ceil(PQ_Number n)
+	{
+		return pq_number_saturate(((int64_t)n + PQ_NUMBER_ONE - 1) & ~(int64_t)(PQ_NUMBER_ONE - 1));
+	}
+
+	// integer square root of n * ONE, one result bit per step
+	static inline PQ_Number pq_math_sqrt(PQ_Number n)
+	{
+		if (n <= 0)
+		{
+			return 0;
+		}
+
+		uint64_t x = (uint64_t)n << PQ_FIXED_FRACTION_BITS;
+		uint64_t r = 0;
+		uint64_t bit = 1ull << 62;
+
+		while (bit > x)
+		{
+			bit >>= 2;
+		}
+
+		while (bit)
+		{
+			if (x >= r + bit)
+			{
+				x -= r + bit;
+				r = (r >> 1) + bit;
+			}
+			else
+			{
+				r >>= 1;
+			}
+
+			bit >>= 2;
+		}
+
+		return (PQ_Number)r;
+	}
+
+	// folded into [-pi/2, pi/2], then taylor up to x^9 in horner form
+	static inline PQ_Number pq_math_sin_wide(int64_t x)
+	{
+		x %= 2 * PQ_MATH_PI;
+
+		if (x > PQ_MATH_PI)  x -= 2 * PQ_MATH_PI;
+		if (x < -PQ_MATH_PI) x += 2 * PQ_MATH_PI;
+
+		if (x > PQ_MATH_HALF_PI)  x = PQ_MATH_PI - x;
+		if (x < -PQ_MATH_HALF_PI) x = -PQ_MATH_PI - x;
+
+		int64_t x2 = (x * x) >> PQ_FIXED_FRACTION_BITS;
+		int64_t r = PQ_NUMBER_ONE;
+
+		r = PQ_NUMBER_ONE - ((x2 * r) >> PQ_FIXED_FRACTION_BITS) / 72;
+		r = PQ_NUMBER_ONE - ((x2 * r) >> PQ_FIXED_FRACTION_BITS) / 42;
+		r = PQ_NUMBER_ONE - ((x2 * r) >> PQ_FIXED_FRACTION_BITS) / 20;
+		r = PQ_NUMBER_ONE - ((x2 * r) >> PQ_FIXED_FRACTION_BITS) / 6;
+
+		return (PQ_Number)((x * r) >> PQ_FIXED_FRACTION_BITS);
+	}
+
+	static inline PQ_Number pq_math_sin(PQ_Number n)
+	{
+		return pq_math_sin_wide(n);
+	}
+
+	static inline PQ_Number pq_math_cos(PQ_Number n)
+	{
+		return pq_math_sin_wide((int64_t)n + PQ_MATH_HALF_PI);
+	}
+
+	static inline PQ_Number pq_math_tan(PQ_Number n)
+	{
+		return pq_number_div(pq_math_sin(n), pq_math_cos(n));
+	}
+
+	// odd minimax polynomial on [-1, 1], atan(x) = pi/2 - atan(1/x) outside of it
+	static inline PQ_Number pq_math_atan(PQ_Number n)
+	{
+		static constexpr int64_t C[] =
+		{
+			(int64_t)( 0.9998660 * PQ_NUMBER_ONE),
+			(int64_t)(-0.3302995 * PQ_NUMBER_ONE),
+			(int64_t)( 0.1801410 * PQ_NUMBER_ONE),
+			(int64_t)(-0.0851330 * PQ_NUMBER_ONE),
+			(int64_t)( 0.0208351 * PQ_NUMBER_ONE),
+		};
+
+		bool negative = n < 0;
+		int64_t x = negative ? -(int64_t)n : n;
+		bool inverted = x > PQ_NUMBER_ONE;
+
+		if (inverted)
+		{
+			x = ((int64_t)PQ_NUMBER_ONE << PQ_FIXED_FRACTION_BITS) / x;
+		}
+
+		int64_t x2 = (x * x) >> PQ_FIXED_FRACTION_BITS;
+		int64_t r = C[4];
+
+		for (int32_t i = 3; i >= 0; i--)
+		{
+			r = C[i] + ((x2 * r) >> PQ_FIXED_FRACTION_BITS);
+		}
+
+		r = (x * r) >> PQ_FIXED_FRACTION_BITS;
+		r = inverted ? PQ_MATH_HALF_PI - r : r;
+
+		return (PQ_Number)(negative ? -r : r);
+	}
+#else
+	static constexpr double PQ_MATH_PI = 3.14159265358979323846;
+
+	// these map to single instructions on wasm and most fpus
+	static inline PQ_Number pq_math_abs(PQ_Number n)   { return __builtin_fabsf(n); }
+	static inline PQ_Number pq_math_floor(PQ_Number n) { return __builtin_floorf(n); }
+	static inline PQ_Number pq_math_ceil(PQ_Number n)  { return __builtin_ceilf(n); }
+	static inline PQ_Number pq_math_sqrt(PQ_Number n)  { return __builtin_sqrtf(n); }
+
+	// done in double so the result rounds to the same float as sinf almost always.
+	// reduced to [-pi, pi], folded into [-pi/2, pi/2], then taylor up to x^13.
+	static inline double pq_math_sin_wide(double x)
+	{
+		x -= 2.0 * PQ_MATH_PI * __builtin_rint(x / (2.0 * PQ_MATH_PI));
+
+		if (x > PQ_MATH_PI / 2.0)  x = PQ_MATH_PI - x;
+		if (x < -PQ_MATH_PI / 2.0) x = -PQ_MATH_PI - x;
+
+		double x2 = x * x;
+		double r = 1.0;
+
+		for (int32_t k = 12; k >= 2; k -= 2)
+		{
+			r = 1.0 - x2 / (double)(k * (k + 1)) * r;
+		}
+
+		return x * r;
+	}
+
+	static inline PQ_Number pq_math_sin(PQ_Number n)
+	{
+		return (float)pq_math_sin_wide(n);
+	}
+
+	static inline PQ_Number pq_math_cos(PQ_Number n)
+	{
+		return (float)pq_math_sin_wide((double)n + PQ_MATH_PI / 2.0);
+	}
+
+	static inline PQ_Number pq_math_tan(PQ_Number n)
+	{
+		return (float)(pq_math_sin_wide(n) / pq_math_sin_wide((double)n + PQ_MATH_PI / 2.0));
+	}
+
+	// reduced to [0, 2 - sqrt(3)] with atan(x) = pi/2 - atan(1/x) and
+	// atan(x) = pi/6 + atan((x * sqrt(3) - 1) / (x + sqrt(3))), then taylor up to x^15
+	static inline PQ_Number pq_math_atan(PQ_Number n)
+	{
+		static constexpr double SQRT_3 = 1.73205080756887729353;
+
+		double x = __builtin_fabs((double)n);
+
+		bool inverted = x > 1.0;
+
+		if (inverted)
+		{
+			x = 1.0 / x;
+		}
+
+		bool shifted = x > 2.0 - SQRT_3;
+
+		if (shifted)
+		{
+			x = (x * SQRT_3 - 1.0) / (x + SQRT_3);
+		}
+
+		double x2 = x * x;
+		double r = 0.0;
+
+		for (int32_t k = 15; k >= 1; k -= 2)
+		{
+			r = 1.0 / k - x2 * r;
+		}
+
+		r *= x;
+		r = shifted ? PQ_MATH_PI / 6.0 + r : r;
+		r = inverted ? PQ_MATH_PI / 2.0 - r : r;
+
+		return (float)(n < 0.0f ? -r : r);
+	}
+#endif
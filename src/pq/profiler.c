@@ -0,0 +1,116 @@
+#include <pq/profiler.h>
+
+static uint32_t hash_frames(const PQ_ProfileFrame* frames, uint16_t depth)
+{
+	uint32_t h = 2166136261u;
+
+	for (uint16_t i = 0; i < depth; i++)
+	{
+		h = (h ^ frames[i].proc) * 16777619u;
+		h = (h ^ frames[i].line) * 16777619u;
+	}
+
+	return h;
+}
+
+//
+// interface
+//
+
+void pq_profiler_init(PQ_Profiler* p, Arena* arena, uint32_t interval)
+{
+	p->interval = MAX(interval, 1u);
+	p->countdown = p->interval;
+
+	p->stacks = arena_push_array_uninit(arena, PQ_ProfileStack, PQ_MAX_PROFILE_STACKS);
+	p->stack_count = 0;
+
+	p->samples = 0;
+	p->dropped = 0;
+}
+
+void pq_profiler_sample(PQ_Profiler* p, const PQ_VM* vm)
+{
+	p->countdown = p->interval;
+	p->samples++;
+
+	PQ_ProfileStack stack = {};
+
+	// walk the calls outwards, from where each frame returns to
+	uint16_t ip = vm->ip;
+
+	for (uint16_t i = vm->call_frame_count; stack.depth < PQ_MAX_PROFILE_DEPTH; i--)
+	{
+		stack.frames[stack.depth++] = (PQ_ProfileFrame){ pq_vm_procedure_at(vm, ip), pq_vm_line_at(vm, ip) };
+
+		// procedures called by the host have no caller in the program
+		if (i == 0 || vm->call_frames[i - 1].host_call)
+		{
+			break;
+		}
+
+		ip = vm->call_frames[i - 1].return_ip - 1;
+	}
+
+	stack.hash = hash_frames(stack.frames, stack.depth);
+
+	for (uint16_t i = 0; i < p->stack_count; i++)
+	{
+		PQ_ProfileStack* it = &p->stacks[i];
+
+		if (it->hash == stack.hash && it->depth == stack.depth && __builtin_memcmp(it->frames, stack.frames, stack.depth * sizeof(PQ_ProfileFrame)) == 0)
+		{
+			it->count++;
+			return;
+		}
+	}
+
+	if (p->stack_count >= PQ_MAX_PROFILE_STACKS)
+	{
+		p->dropped++;
+		return;
+	}
+
+	stack.count = 1;
+
+	p->stacks[p->stack_count++] = stack;
+}
+
+void pq_profiler_write_folded(const PQ_Profiler* p, const PQ_VM* vm, PQ_ProfileOutputFn out)
+{
+	char line[PQ_MAX_PROFILE_DEPTH * 64 + 16];
+
+	for (uint16_t i = 0; i < p->stack_count; i++)
+	{
+		const PQ_ProfileStack* stack = &p->stacks[i];
+
+		size_t length = 0;
+
+		for (uint16_t j = stack->depth; j-- > 0;)
+		{
+			const PQ_ProfileFrame f = stack->frames[j];
+			const char* separator = j + 1 < stack->depth ? ";" : "";
+
+			String name = s("main");
+
+			if (f.proc != PQ_NO_PROCEDURE)
+			{
+				name = vm->proc_infos[f.proc].name;
+			}
+
+			// at most 64 characters a frame, so the line always fits
+			if (name.length == 0)
+			{
+				length += snprintf(line + length, 64, "%s#%d:%d", separator, f.proc, f.line);
+			}
+			else
+			{
+				length += snprintf(line + length, 64, "%s%.*s:%d", separator, (int)MIN(name.length, (size_t)48), name.buffer, f.line);
+			}
+		}
+
+		snprintf(line + length, 16, " %u\n", stack->count);
+
+		out(line);
+	}
+}
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <base/common.h>
+#include <base/arena.h>
+
+#include <pq/vm.h>
+#include <pq/config.h>
+
+// a procedure, and the line it's at: the current one for the innermost frame,
+// the line of the call for the others.
+typedef struct PQ_ProfileFrame PQ_ProfileFrame;
+struct PQ_ProfileFrame
+{
+	uint16_t proc;
+	uint16_t line;
+};
+
+typedef struct PQ_ProfileStack PQ_ProfileStack;
+struct PQ_ProfileStack
+{
+	uint32_t hash;
+	uint32_t count;
+
+	// innermost first
+	PQ_ProfileFrame frames[PQ_MAX_PROFILE_DEPTH];
+	uint16_t depth;
+};
+
+// a sampling profiler. attached to a vm (see PQ_VM.profiler), it takes a
+// snapshot of the call stack every `interval` instructions, and counts how
+// often each distinct one came up. names and lines come from the debug info
+// of the blob, see PQ_Compiler.debug_info.
+struct PQ_Profiler
+{
+	uint32_t interval;
+	uint32_t countdown;
+
+	PQ_ProfileStack* stacks;
+	uint16_t stack_count;
+
+	uint32_t samples;
+
+	// samples of stacks that didn't fit, once PQ_MAX_PROFILE_STACKS were seen
+	uint32_t dropped;
+};
+
+typedef void (*PQ_ProfileOutputFn)(const char*);
+
+void pq_profiler_init(PQ_Profiler* p, Arena* arena, uint32_t interval);
+
+// called by the vm, before the instruction at vm->ip runs
+void pq_profiler_sample(PQ_Profiler* p, const PQ_VM* vm);
+
+// one line per stack in the "folded" format flame graph tools read: frames
+// from the outermost in, separated by `;`, then the sample count. a frame is
+// written as `name:line`. top level code is `main`.
+void pq_profiler_write_folded(const PQ_Profiler* p, const PQ_VM* vm, PQ_ProfileOutputFn out);
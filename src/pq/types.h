@@ -4,6 +4,94 @@
 #include <base/string.h>
 #include <base/arena.h>
 
+#include <pq/config.h>
+
+//
+// number
+//
+// floats by default. with PQ_FIXED_POINT numbers are fixed point integers 
+// with PQ_FIXED_FRACTION_BITS fractional bits and every operation saturates 
+// instead of wrapping around. there's no nan, so null reads as 0.
+//
+
+#if defined PQ_FIXED_POINT
+	typedef int32_t PQ_Number;
+
+	static constexpr int32_t PQ_NUMBER_ONE = 1 << PQ_FIXED_FRACTION_BITS;
+	static constexpr PQ_Number PQ_NUMBER_NULL = 0;
+
+	static inline PQ_Number pq_number_saturate(int64_t v)
+	{
+		return (PQ_Number)(v > INT32_MAX ? INT32_MAX : v < INT32_MIN ? INT32_MIN : v);
+	}
+
+	static inline PQ_Number pq_number_from_float(float f)
+	{
+		if (f != f)
+		{
+			return 0;
+		}
+
+		// clamped first, converting an out of range float is undefined
+		float scaled = CLAMP(f * (float)PQ_NUMBER_ONE, -2147483648.0f, 2147483648.0f);
+
+		return pq_number_saturate((int64_t)(scaled + (scaled < 0.0f ? -0.5f : 0.5f)));
+	}
+
+	static inline float pq_number_to_float(PQ_Number n) { return (float)n / (float)PQ_NUMBER_ONE; }
+	static inline PQ_Number pq_number_from_int(int32_t i) { return pq_number_saturate((int64_t)i * PQ_NUMBER_ONE); }
+	static inline int32_t pq_number_to_int(PQ_Number n) { return n / PQ_NUMBER_ONE; }
+	static inline uint32_t pq_number_to_bits(PQ_Number n) { return (uint32_t)pq_number_to_int(n); }
+
+	static inline PQ_Number pq_number_add(PQ_Number a, PQ_Number b) { return pq_number_saturate((int64_t)a + b); }
+	static inline PQ_Number pq_number_sub(PQ_Number a, PQ_Number b) { return pq_number_saturate((int64_t)a - b); }
+	static inline PQ_Number pq_number_mul(PQ_Number a, PQ_Number b) { return pq_number_saturate(((int64_t)a * b) >> PQ_FIXED_FRACTION_BITS); }
+
+	// dividing by zero saturates towards the sign of a, like float goes to inf
+	static inline PQ_Number pq_number_div(PQ_Number a, PQ_Number b)
+	{
+		if (b == 0)
+		{
+			return a < 0 ? INT32_MIN : a > 0 ? INT32_MAX : 0;
+		}
+
+		return pq_number_saturate(((int64_t)a * PQ_NUMBER_ONE) / b);
+	}
+
+	// same sign as a, like fmodf
+	static inline PQ_Number pq_number_mod(PQ_Number a, PQ_Number b)
+	{
+		return b == 0 ? 0 : (PQ_Number)((int64_t)a % b);
+	}
+#else
+	typedef float PQ_Number;
+
+	static constexpr PQ_Number PQ_NUMBER_NULL = __builtin_nanf("");
+
+	static inline PQ_Number pq_number_from_float(float f) { return f; }
+	static inline float pq_number_to_float(PQ_Number n) { return n; }
+	static inline PQ_Number pq_number_from_int(int32_t i) { return (float)i; }
+
+	// converting nan or an out of range float is undefined, so those saturate
+	static inline int32_t pq_number_to_int(PQ_Number n)
+	{
+		if (n != n)
+		{
+			return 0;
+		}
+
+		return n >= 2147483648.0f ? INT32_MAX : n < -2147483648.0f ? INT32_MIN : (int32_t)n;
+	}
+
+	static inline uint32_t pq_number_to_bits(PQ_Number n) { return (uint32_t)n; }
+
+	static inline PQ_Number pq_number_add(PQ_Number a, PQ_Number b) { return a + b; }
+	static inline PQ_Number pq_number_sub(PQ_Number a, PQ_Number b) { return a - b; }
+	static inline PQ_Number pq_number_mul(PQ_Number a, PQ_Number b) { return a * b; }
+	static inline PQ_Number pq_number_div(PQ_Number a, PQ_Number b) { return a / b; }
+	static inline PQ_Number pq_number_mod(PQ_Number a, PQ_Number b) { return __builtin_fmodf(a, b); }
+#endif
+
 //
 // value
 //
@@ -15,6 +103,11 @@ typedef enum : uint8_t
 	VALUE_BOOLEAN,
 	VALUE_STRING,
 	VALUE_ARRAY,
+	VALUE_INT,
+
+	// packed arrays, bare int32_t or PQ_Number elements (4 bytes each)
+	VALUE_INT_ARRAY,
+	VALUE_NUMBER_ARRAY,
 } PQ_ValueType;
 
 typedef struct PQ_Value PQ_Value;
@@ -22,15 +115,26 @@ struct PQ_Value
 {
 	PQ_ValueType type;
 
+	// strings loaded from a blob are interned, equal ones share the same 
+	// buffer and id (0 means not interned). fits in the padding after `type`.
+	uint16_t intern;
+
 	union
 	{
-		float n;
+		PQ_Number n;
+		int32_t i;
 		bool b; 
 		String s;
 		
 		struct 
 		{
-			struct PQ_Value* elements;
+			union
+			{
+				struct PQ_Value* elements;
+				int32_t* ints;
+				PQ_Number* numbers;
+			};
+
 			uint16_t count; // immutable
 		} a;
 	};
@@ -38,7 +142,9 @@ struct PQ_Value
 
 #define pq_value_array(arena, N) ((PQ_Value){ VALUE_ARRAY, .a = { .elements = arena_push_array((arena), PQ_Value, (N)), .count = (N) } })
 #define pq_value_null()          ((PQ_Value){ VALUE_NULL })
-#define pq_value_number(v)       ((PQ_Value){ VALUE_NUMBER, .n = (float)(v) })
+#define pq_value_number(v)       ((PQ_Value){ VALUE_NUMBER, .n = pq_number_from_float((float)(v)) })
+#define pq_value_from_pq_number(v) ((PQ_Value){ VALUE_NUMBER, .n = (v) })
+#define pq_value_int(v)          ((PQ_Value){ VALUE_INT, .i = (int32_t)(v) })
 #define pq_value_boolean(v)      ((PQ_Value){ VALUE_BOOLEAN, .b = (bool)(v) })
 #define pq_value_string(v)       ((PQ_Value){ VALUE_STRING, .s = v })
 
@@ -48,34 +154,45 @@ static inline const char* pq_value_to_c_str(const PQ_ValueType type)
 	{
 		case VALUE_NULL:    return "null";
 		case VALUE_NUMBER:  return "number"; 
+		case VALUE_INT:     return "int"; 
 		case VALUE_STRING:  return "string"; 
 		case VALUE_BOOLEAN: return "boolean";
 		case VALUE_ARRAY:   return "array"; 
+		case VALUE_INT_ARRAY:    return "int array"; 
+		case VALUE_NUMBER_ARRAY: return "number array"; 
 
 		default: return "unknown";
 	}
 }
 
-static inline float pq_value_as_number(const PQ_Value v)
+// PQ_Number, no conversion to float when built with PQ_FIXED_POINT
+static inline PQ_Number pq_value_as_pq_number(const PQ_Value v)
 {
 	switch (v.type) 
 	{
-		case VALUE_NULL:    return __builtin_nanf("");
+		case VALUE_NULL:    return PQ_NUMBER_NULL;
 		case VALUE_NUMBER:  return v.n;
-		case VALUE_STRING:  return 0.0f;
-		case VALUE_BOOLEAN: return (float)v.b;
-		case VALUE_ARRAY:   return 0.0f;
+		case VALUE_INT:     return pq_number_from_int(v.i);
+		case VALUE_STRING:  return pq_number_from_int(0);
+		case VALUE_BOOLEAN: return pq_number_from_int(v.b);
+		case VALUE_ARRAY:   return pq_number_from_int(0);
 
-		default: return 0.0f;
+		default: return pq_number_from_int(0);
 	}
 }
 
+static inline float pq_value_as_number(const PQ_Value v)
+{
+	return pq_number_to_float(pq_value_as_pq_number(v));
+}
+
 static inline bool pq_value_as_boolean(const PQ_Value v)
 {
 	switch (v.type) 
 	{
 		case VALUE_NULL:    return false;
-		case VALUE_NUMBER:  return (bool)v.n;
+		case VALUE_NUMBER:  return v.n != 0;
+		case VALUE_INT:     return v.i != 0;
 		case VALUE_STRING:  return false;
 		case VALUE_BOOLEAN: return v.b;
 		case VALUE_ARRAY:   return false;
@@ -88,16 +205,26 @@ static inline String pq_value_as_string(Arena* arena, const PQ_Value v)
 {
 	switch (v.type) 
 	{
-		case VALUE_NULL:    return str_copy(arena, s("null"));
-		case VALUE_NUMBER:  return str_format(arena, "%f", v.n);
-		case VALUE_STRING:  return str_copy_from_to(arena, v.s, 1, v.s.length - 1);
-		case VALUE_BOOLEAN: return str_format(arena, "%s", v.b ? "true" : "false");
+		case VALUE_NULL:    return s("null");
+#if defined PQ_FIXED_POINT
+		case VALUE_NUMBER:  return str_from_fixed(arena, v.n, PQ_FIXED_FRACTION_BITS);
+#else
+		case VALUE_NUMBER:  return str_from_number(arena, v.n);
+#endif
+		case VALUE_INT:     return str_from_int(arena, v.i);
+		case VALUE_STRING:  return v.s;
+		case VALUE_BOOLEAN: return v.b ? s("true") : s("false");
 		case VALUE_ARRAY:   return (String){};
 
 		default: return (String){};
 	}
 }
 
+static inline int32_t pq_value_as_int(const PQ_Value v)
+{
+	return v.type == VALUE_INT ? v.i : pq_number_to_int(pq_value_as_pq_number(v));
+}
+
 static inline bool pq_value_can_be_number(PQ_Value l)
 {
 	switch (l.type)
@@ -105,38 +232,132 @@ static inline bool pq_value_can_be_number(PQ_Value l)
 		case VALUE_BOOLEAN: return true;
 		case VALUE_NULL:    return true;
 		case VALUE_NUMBER:  return true;
+		case VALUE_INT:     return true;
 
 		default: return false;
 	}
 }
 
+static inline bool pq_value_is_array(const PQ_Value v)
+{
+	return v.type == VALUE_ARRAY || v.type == VALUE_INT_ARRAY || v.type == VALUE_NUMBER_ARRAY;
+}
+
+// elements of packed arrays are converted on the way in and out, `i` has to be in bounds
+static inline PQ_Value pq_value_array_get(const PQ_Value array, uint16_t i)
+{
+	switch (array.type)
+	{
+		case VALUE_INT_ARRAY:    return pq_value_int(array.a.ints[i]);
+		case VALUE_NUMBER_ARRAY: return pq_value_from_pq_number(array.a.numbers[i]);
+
+		default: return array.a.elements[i];
+	}
+}
+
+static inline void pq_value_array_set(PQ_Value array, uint16_t i, PQ_Value v)
+{
+	switch (array.type)
+	{
+		case VALUE_INT_ARRAY:    array.a.ints[i] = pq_value_as_int(v); break;
+		case VALUE_NUMBER_ARRAY: array.a.numbers[i] = pq_value_as_pq_number(v); break;
+
+		default: array.a.elements[i] = v;
+	}
+}
+
+// promotion rules: the compiler picks the _int operations when both sides are 
+// known to be ints (int literals, variables declared `var <ident>: int`, bitwise 
+// results). those give an int, unless it would overflow, then it's promoted to 
+// float. untyped values go through float (PQ_Number) like they always did, 
+// whatever they hold. division always gives a float, bitwise operations always 
+// give an int (the 32 bits, reinterpreted as signed).
+
 #define DEFINE_VALUE_OPERATIONS \
-	OP(add, number, number, +) \
-	OP(sub, number, number, -) \
-	OP(div, number, number, /) \
-	OP(mul, number, number, *) \
-	\
-	OP(and,     boolean, number, &&) \
-	OP(or,      boolean, number, ||) \
-	OP(greater, boolean, number, >) \
-	OP(less,    boolean, number, <) \
-	OP(gt,      boolean, number, >=) \
-	OP(lt,      boolean, number, <=)
+	OP(and, &&) \
+	OP(or,  ||)
 
-#define OP(name, ret_type, type, op) \
-	static inline PQ_Value pq_value_##name(PQ_Value l, PQ_Value r) { return pq_value_##ret_type(pq_value_as_##type(l) op pq_value_as_##type(r)); }
+#define OP(name, op) \
+	static inline PQ_Value pq_value_##name(PQ_Value l, PQ_Value r) { return pq_value_boolean(pq_value_as_pq_number(l) op pq_value_as_pq_number(r)); }
 
 DEFINE_VALUE_OPERATIONS
 
+#undef OP
+#undef DEFINE_VALUE_OPERATIONS
+
+static inline PQ_Value pq_value_div(PQ_Value l, PQ_Value r)
+{
+	return pq_value_from_pq_number(pq_number_div(pq_value_as_pq_number(l), pq_value_as_pq_number(r)));
+}
+
+#define DEFINE_ARITHMETIC_OPERATIONS \
+	OP(add, __builtin_add_overflow) \
+	OP(sub, __builtin_sub_overflow) \
+	OP(mul, __builtin_mul_overflow)
+
+#define OP(name, checked_op) \
+	static inline PQ_Value pq_value_##name(PQ_Value l, PQ_Value r) \
+	{ \
+		return pq_value_from_pq_number(pq_number_##name(pq_value_as_pq_number(l), pq_value_as_pq_number(r))); \
+	} \
+	\
+	static inline PQ_Value pq_value_##name##_int(PQ_Value l, PQ_Value r) \
+	{ \
+		int32_t i = 0; \
+		\
+		if (checked_op(l.i, r.i, &i)) \
+		{ \
+			return pq_value_##name(l, r); \
+		} \
+		\
+		return pq_value_int(i); \
+	}
+
+DEFINE_ARITHMETIC_OPERATIONS
+
+#undef OP
+#undef DEFINE_ARITHMETIC_OPERATIONS
+
+#define DEFINE_COMPARISON_OPERATIONS \
+	OP(greater, >) \
+	OP(less,    <) \
+	OP(gt,      >=) \
+	OP(lt,      <=)
+
+#define OP(name, op) \
+	static inline PQ_Value pq_value_##name(PQ_Value l, PQ_Value r) { return pq_value_boolean(pq_value_as_pq_number(l) op pq_value_as_pq_number(r)); } \
+	static inline PQ_Value pq_value_##name##_int(PQ_Value l, PQ_Value r) { return pq_value_boolean(l.i op r.i); }
+
+DEFINE_COMPARISON_OPERATIONS
+
+#undef OP
+#undef DEFINE_COMPARISON_OPERATIONS
+
 static inline PQ_Value pq_value_mod(PQ_Value l, PQ_Value r)
 {
-	return pq_value_number(__builtin_fmodf(pq_value_as_number(l), pq_value_as_number(r)));
+	return pq_value_from_pq_number(pq_number_mod(pq_value_as_pq_number(l), pq_value_as_pq_number(r)));
+}
+
+static inline PQ_Value pq_value_mod_int(PQ_Value l, PQ_Value r)
+{
+	// 0 and -1 are left to float, INT32_MIN % -1 traps
+	if (r.i > 0 || r.i < -1)
+	{
+		return pq_value_int(l.i % r.i);
+	}
+
+	return pq_value_mod(l, r);
 }
 
 static inline PQ_Value pq_value_equals(PQ_Value l, PQ_Value r)
 {
 	if (l.type == VALUE_STRING && r.type == VALUE_STRING)
 	{
+		if (l.intern && r.intern)
+		{
+			return pq_value_boolean(l.intern == r.intern);
+		}
+
 		return pq_value_boolean(str_equals(l.s, r.s));
 	}
 
@@ -147,45 +368,50 @@ static inline PQ_Value pq_value_equals(PQ_Value l, PQ_Value r)
 
 	if (pq_value_can_be_number(l) && pq_value_can_be_number(r))
 	{
-		return pq_value_boolean(pq_value_as_number(l) == pq_value_as_number(r));
+		return pq_value_boolean(pq_value_as_pq_number(l) == pq_value_as_pq_number(r));
 	}
 
 	return pq_value_boolean(false);
 }
 
-static inline PQ_Value pq_value_not(PQ_Value l)
+static inline PQ_Value pq_value_equals_int(PQ_Value l, PQ_Value r)
 {
-	return pq_value_boolean(!pq_value_as_boolean(l));
+	return pq_value_boolean(l.i == r.i);
 }
 
-static inline PQ_Value pq_value_bw_or(PQ_Value l, PQ_Value r)
+static inline PQ_Value pq_value_not(PQ_Value l)
 {
-	return pq_value_number((float)((uint32_t)pq_value_as_number(l) | (uint32_t)pq_value_as_number(r)));
+	return pq_value_boolean(!pq_value_as_boolean(l));
 }
 
-static inline PQ_Value pq_value_bw_and(PQ_Value l, PQ_Value r)
+static inline uint32_t pq_value_as_bits(const PQ_Value v)
 {
-	return pq_value_number((float)((uint32_t)pq_value_as_number(l) & (uint32_t)pq_value_as_number(r)));
+	return v.type == VALUE_INT ? (uint32_t)v.i : pq_number_to_bits(pq_value_as_pq_number(v));
 }
 
-static inline PQ_Value pq_value_bw_xor(PQ_Value l, PQ_Value r)
-{
-	return pq_value_number((float)((uint32_t)pq_value_as_number(l) ^ (uint32_t)pq_value_as_number(r)));
-}
+#define DEFINE_BITWISE_OPERATIONS \
+	OP(bw_or,  |) \
+	OP(bw_and, &) \
+	OP(bw_xor, ^)
+
+#define OP(name, op) \
+	static inline PQ_Value pq_value_##name(PQ_Value l, PQ_Value r) { return pq_value_int((int32_t)(pq_value_as_bits(l) op pq_value_as_bits(r))); }
+
+DEFINE_BITWISE_OPERATIONS
+
+#undef OP
+#undef DEFINE_BITWISE_OPERATIONS
 
 static inline PQ_Value pq_value_bw_left_shift(PQ_Value l, PQ_Value r)
 {
-	return pq_value_number((float)((uint32_t)pq_value_as_number(l) << (uint32_t)pq_value_as_number(r)));
+	return pq_value_int((int32_t)(pq_value_as_bits(l) << (pq_value_as_bits(r) & 31)));
 }
 
 static inline PQ_Value pq_value_bw_right_shift(PQ_Value l, PQ_Value r)
 {
-	return pq_value_number((float)((uint32_t)pq_value_as_number(l) >> (uint32_t)pq_value_as_number(r)));
+	return pq_value_int((int32_t)(pq_value_as_bits(l) >> (pq_value_as_bits(r) & 31)));
 }
 
-#undef OP
-#undef DEFINE_VALUE_OPERATIONS
-
 //
 // instructions
 //
@@ -197,11 +423,26 @@ static inline PQ_Value pq_value_bw_right_shift(PQ_Value l, PQ_Value r)
 	INST(STORE_LOCAL) \
 	INST(LOAD_GLOBAL) \
 	INST(STORE_GLOBAL) \
+	INST(STORE_LOCAL_INT) \
+	INST(STORE_GLOBAL_INT) \
 	INST(LOAD_LOCAL_SUBSCRIPT) \
 	INST(STORE_LOCAL_SUBSCRIPT) \
 	INST(LOAD_GLOBAL_SUBSCRIPT) \
 	INST(STORE_GLOBAL_SUBSCRIPT) \
+	INST(LOAD_LOCAL_INT_SUBSCRIPT) \
+	INST(STORE_LOCAL_INT_SUBSCRIPT) \
+	INST(LOAD_GLOBAL_INT_SUBSCRIPT) \
+	INST(STORE_GLOBAL_INT_SUBSCRIPT) \
+	INST(LOAD_LOCAL_NUMBER_SUBSCRIPT) \
+	INST(STORE_LOCAL_NUMBER_SUBSCRIPT) \
+	INST(LOAD_GLOBAL_NUMBER_SUBSCRIPT) \
+	INST(STORE_GLOBAL_NUMBER_SUBSCRIPT) \
 	INST(LOAD_ARRAY) \
+	INST(LOAD_ARRAY_UNINIT) \
+	INST(LOAD_INT_ARRAY) \
+	INST(LOAD_NUMBER_ARRAY) \
+	INST(ENTER_SCOPE) \
+	INST(LEAVE_SCOPE) \
 	INST(JUMP) \
 	INST(JUMP_COND) \
 	INST(LOAD_NULL) \
@@ -217,8 +458,25 @@ static inline PQ_Value pq_value_bw_right_shift(PQ_Value l, PQ_Value r)
 	INST(EQUALS) \
 	INST(GREATER) \
 	INST(LESS) \
+	INST(ADD_INT) \
+	INST(SUB_INT) \
+	INST(MUL_INT) \
+	INST(MOD_INT) \
+	INST(GREATER_THAN_INT) \
+	INST(LESS_THAN_INT) \
+	INST(EQUALS_INT) \
+	INST(GREATER_INT) \
+	INST(LESS_INT) \
 	INST(NOT) \
 	INST(NEGATE) \
+	INST(ABS) \
+	INST(FLOOR) \
+	INST(CEIL) \
+	INST(SQRT) \
+	INST(SIN) \
+	INST(COS) \
+	INST(TAN) \
+	INST(ATAN) \
 	INST(BW_OR) \
 	INST(BW_AND) \
 	INST(BW_XOR) \
@@ -232,6 +490,8 @@ static inline PQ_Value pq_value_bw_right_shift(PQ_Value l, PQ_Value r)
 typedef enum : uint8_t
 {
 	DEFINE_INSTRUCTIONS
+
+	INST_COUNT
 } PQ_InstructionType;
 
 typedef struct PQ_Instruction PQ_Instruction;
@@ -249,6 +509,8 @@ static inline const char* pq_inst_to_c_str(const PQ_InstructionType type)
 	switch (type)
 	{
 		DEFINE_INSTRUCTIONS
+
+		default: break;
 	}
 	
 	return "unknown";
@@ -327,7 +589,8 @@ static inline bool pq_inst_needs_arg(const PQ_InstructionType type)
 	TOKEN(CLOSE_PAREN,        "`)`") \
 	TOKEN(OPEN_BOX,           "`[`") \
 	TOKEN(CLOSE_BOX,          "`]`") \
-	TOKEN(COMMA,              "`,`")
+	TOKEN(COMMA,              "`,`") \
+	TOKEN(COLON,              "`:`")
 
 #define TOKEN(name, fancy_name) TOKEN_##name,
 
@@ -424,4 +687,66 @@ struct PQ_CompiledBlob
 {
 	uint8_t* buffer;
 	uint16_t size;
-};
\ No newline at end of file
+};
+
+// "PQDB", starts the debug info after the program (see PQ_Compiler.debug_info)
+static constexpr uint32_t PQ_DEBUG_INFO_MAGIC = 0x50514442u;
+
+//
+// foreign procedures
+//
+// a registry is a fixed table of natives, blobs refer to its procedures by 
+// their ordinal (position in the table) and record its version. natives 
+// declared one by one are found by a hash of their name instead.
+//
+
+typedef struct PQ_VM PQ_VM;
+
+// called straight on the arguments, still on the stack, without a call frame.
+// returns the value instead of pushing it (pq_value_null() for nothing), the
+// arguments can't be used after pushing to the stack.
+typedef PQ_Value (*PQ_FastNativeProcedure)(PQ_VM* vm, const PQ_Value* args, uint16_t argc);
+
+typedef struct PQ_ForeignProc PQ_ForeignProc;
+struct PQ_ForeignProc
+{
+	String name;
+	uint16_t arg_count;
+	PQ_FastNativeProcedure proc;
+};
+
+typedef struct PQ_ForeignRegistry PQ_ForeignRegistry;
+struct PQ_ForeignRegistry
+{
+	uint16_t version;
+
+	const PQ_ForeignProc* procs;
+	uint16_t proc_count;
+};
+
+static constexpr uint16_t PQ_FOREIGN_UNREGISTERED = UINT16_MAX;
+
+// the first byte of every procedure in a blob. programs may define `update(dt)`
+// and `draw()`, the host then calls them once per frame after the top level
+// code halts (see pq_vm_call).
+typedef enum : uint8_t
+{
+	PQ_PROCEDURE_FOREIGN = 1 << 0,
+	PQ_PROCEDURE_UPDATE  = 1 << 1,
+	PQ_PROCEDURE_DRAW    = 1 << 2,
+} PQ_ProcedureFlags;
+
+static constexpr uint16_t PQ_NO_PROCEDURE = UINT16_MAX;
+
+// fnv-1a
+static inline uint32_t pq_foreign_hash(String name)
+{
+	uint32_t h = 2166136261u;
+
+	for (size_t i = 0; i < name.length; i++)
+	{
+		h = (h ^ (uint8_t)name.buffer[i]) * 16777619u;
+	}
+
+	return h;
+}
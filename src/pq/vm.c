@@ -1,4 +1,6 @@
 #include <pq/vm.h>
+#include <pq/math.h>
+#include <pq/profiler.h>
 
 #define VM_ERROR(...) \
 	do \
@@ -35,7 +37,7 @@ static void read_immediates(PQ_VM* vm, const PQ_CompiledBlob* b)
 {
 	read_from_blob(vm, b, &vm->immediate_count, sizeof(uint16_t));
 
-	vm->immediates = arena_push_array(vm->arena, PQ_Value, vm->immediate_count);
+	vm->immediates = arena_push_array_uninit(vm->arena, PQ_Value, vm->immediate_count);
 
 	for (uint16_t i = 0; i < vm->immediate_count; i++)
 	{
@@ -47,7 +49,15 @@ static void read_immediates(PQ_VM* vm, const PQ_CompiledBlob* b)
 		{
 			case VALUE_NULL: break;
 			
-			case VALUE_NUMBER:  read_from_blob(vm, b, &v.n, sizeof(float)); break; 
+			case VALUE_NUMBER:
+			{
+				float n = 0.0f;
+				read_from_blob(vm, b, &n, sizeof(float));
+
+				v.n = pq_number_from_float(n);
+			} break;
+
+			case VALUE_INT:     read_from_blob(vm, b, &v.i, sizeof(int32_t)); break; 
 			case VALUE_BOOLEAN: read_from_blob(vm, b, &v.b, sizeof(bool)); break; 
 
 			case VALUE_STRING:
@@ -60,7 +70,25 @@ static void read_immediates(PQ_VM* vm, const PQ_CompiledBlob* b)
 					end++;
 				}
 
-				v.s = str_copy_c_str_from_to(vm->arena, (char*)b->buffer, start, end);
+				String s = { (char*)b->buffer + start, end - start };
+
+				// intern, so equal strings compare by id and share a single copy
+				for (uint16_t j = 0; j < i; j++)
+				{
+					const PQ_Value* it = &vm->immediates[j];
+
+					if (it->type == VALUE_STRING && str_equals(it->s, s))
+					{
+						v = *it;
+						break;
+					}
+				}
+
+				if (!v.intern)
+				{
+					v.s = str_copy(vm->arena, s);
+					v.intern = i + 1;
+				}
 			} break;
 
 			default: VM_ERROR("Invalid value type");
@@ -72,30 +100,48 @@ static void read_immediates(PQ_VM* vm, const PQ_CompiledBlob* b)
 
 static void read_procedures(PQ_VM* vm, const PQ_CompiledBlob* b)
 {
+	read_from_blob(vm, b, &vm->registry_version, sizeof(uint16_t));
 	read_from_blob(vm, b, &vm->proc_info_count, sizeof(uint16_t));
 
-	vm->proc_infos = arena_push_array(vm->arena, PQ_ProcedureInfo, vm->proc_info_count);
+	vm->proc_infos = arena_push_array_uninit(vm->arena, PQ_ProcedureInfo, vm->proc_info_count);
+
+	vm->update_proc = PQ_NO_PROCEDURE;
+	vm->draw_proc = PQ_NO_PROCEDURE;
 
 	for (uint16_t i = 0; i < vm->proc_info_count; i++)
 	{
 		PQ_ProcedureInfo pi = {};
 
-		read_from_blob(vm, b, &pi.foreign, sizeof(bool));
-		read_from_blob(vm, b, &pi.local_count, sizeof(uint16_t));
+		uint8_t flags = 0;
+
+		read_from_blob(vm, b, &flags, sizeof(uint8_t));
 		read_from_blob(vm, b, &pi.arg_count, sizeof(uint16_t));
-		read_from_blob(vm, b, &pi.first_inst, sizeof(uint16_t));
+
+		pi.foreign = flags & PQ_PROCEDURE_FOREIGN;
+
+		if (flags & PQ_PROCEDURE_UPDATE)
+		{
+			vm->update_proc = i;
+		}
+
+		if (flags & PQ_PROCEDURE_DRAW)
+		{
+			vm->draw_proc = i;
+		}
 
 		if (pi.foreign)
 		{
-			uint16_t start = vm->bp;
-			uint16_t end = start;
-	
-			while (b->buffer[vm->bp++])
+			read_from_blob(vm, b, &pi.ordinal, sizeof(uint16_t));
+
+			if (pi.ordinal == PQ_FOREIGN_UNREGISTERED)
 			{
-				end++;
+				read_from_blob(vm, b, &pi.hash, sizeof(uint32_t));
 			}
-			
-			pi.foreign_name = str_copy_c_str_from_to(vm->arena, (char*)b->buffer, start, end);
+		}
+		else
+		{
+			read_from_blob(vm, b, &pi.local_count, sizeof(uint16_t));
+			read_from_blob(vm, b, &pi.first_inst, sizeof(uint16_t));
 		}
 		
 		vm->proc_infos[i] = pi;
@@ -106,7 +152,7 @@ static void read_global_count(PQ_VM* vm, const PQ_CompiledBlob* b)
 {
 	read_from_blob(vm, b, &vm->global_count, sizeof(uint16_t));
 
-	vm->globals = arena_push_array(vm->arena, PQ_Value, vm->global_count);
+	vm->globals = arena_push_array_uninit(vm->arena, PQ_Value, vm->global_count);
 
 	for (uint16_t i = 0; i < vm->global_count; i++)
 	{
@@ -128,7 +174,7 @@ static void read_instructions(PQ_VM* vm, const PQ_CompiledBlob* b)
 {
 	read_from_blob(vm, b, &vm->instruction_count, sizeof(uint16_t));
 
-	vm->instructions = arena_push_array(vm->arena, PQ_Instruction, vm->instruction_count);
+	vm->instructions = arena_push_array_uninit(vm->arena, PQ_Instruction, vm->instruction_count);
 
 	for (uint16_t i = 0; i < vm->instruction_count; i++)
 	{
@@ -145,16 +191,109 @@ static void read_instructions(PQ_VM* vm, const PQ_CompiledBlob* b)
 	}
 }
 
+// optional, see write_debug_info
+static void read_debug_info(PQ_VM* vm, const PQ_CompiledBlob* b)
+{
+	vm->line_runs = nullptr;
+	vm->line_run_count = 0;
+
+	if (vm->bp >= b->size)
+	{
+		return;
+	}
+
+	uint32_t magic = 0;
+
+	read_from_blob(vm, b, &magic, sizeof(uint32_t));
+
+	if (magic != __builtin_bswap32(PQ_DEBUG_INFO_MAGIC))
+	{
+		VM_ERROR("Invalid debug info");
+		return;
+	}
+
+	for (uint16_t i = 0; i < vm->proc_info_count; i++)
+	{
+		PQ_ProcedureInfo* pi = &vm->proc_infos[i];
+
+		uint8_t length = 0;
+
+		read_from_blob(vm, b, &length, sizeof(uint8_t));
+
+		pi->name = str_copy(vm->arena, (String){ (char*)b->buffer + vm->bp, length });
+		vm->bp += length;
+
+		if (!pi->foreign)
+		{
+			read_from_blob(vm, b, &pi->last_inst, sizeof(uint16_t));
+		}
+	}
+
+	read_from_blob(vm, b, &vm->line_run_count, sizeof(uint16_t));
+
+	vm->line_runs = arena_push_array_uninit(vm->arena, PQ_LineRun, vm->line_run_count);
+
+	for (uint16_t i = 0; i < vm->line_run_count; i++)
+	{
+		read_from_blob(vm, b, &vm->line_runs[i].first_inst, sizeof(uint16_t));
+		read_from_blob(vm, b, &vm->line_runs[i].line, sizeof(uint16_t));
+	}
+}
+
 static void read_blob(PQ_VM* vm, const PQ_CompiledBlob* b)
 {	
+	ArenaTag tag = arena_set_tag(vm->arena, ARENA_TAG_SYMBOLS);
+
 	read_magic(vm, b);
 	read_immediates(vm, b);
 	read_procedures(vm, b);
+
+	arena_set_tag(vm->arena, ARENA_TAG_VM_STACK);
+
 	read_global_count(vm, b);
 	read_local_count(vm, b);
+
+	arena_set_tag(vm->arena, ARENA_TAG_INSTRUCTIONS);
+
 	read_instructions(vm, b);
+
+	if (vm->bp > PQ_MAX_BLOB_SIZE)
+	{
+		VM_ERROR("Provided blob is too big");
+	}
+
+	arena_set_tag(vm->arena, ARENA_TAG_SYMBOLS);
+
+	read_debug_info(vm, b);
+
+	arena_set_tag(vm->arena, tag);
 }
 
+//
+// instrumentation
+//
+
+#if defined PQ_INSTRUMENT
+	static uint64_t stats_now(const PQ_VM* vm)
+	{
+		return vm->stats ? vm->stats->cycles() : 0;
+	}
+
+	static void stats_count(const PQ_VM* vm, PQ_Counter* c, uint64_t started)
+	{
+		c->count++;
+		c->cycles += vm->stats->cycles() - started;
+	}
+
+	static void stats_count_call(const PQ_VM* vm, uint16_t idx, uint64_t started)
+	{
+		if (vm->stats)
+		{
+			stats_count(vm, &vm->stats->procedures[idx], started);
+		}
+	}
+#endif
+
 //
 // instructions
 //
@@ -192,6 +331,46 @@ static void CALL(PQ_VM* vm, uint16_t idx)
 
 	const PQ_ProcedureInfo* pi = &vm->proc_infos[idx];
 
+	// fast foreign procedures read their arguments in place, no frame or locals
+	if (pi->fast_proc)
+	{
+		if (vm->stack_size < pi->arg_count)
+		{
+			VM_ERROR("Stack underflow");
+			return;
+		}
+
+		vm->stack_size -= pi->arg_count;
+		vm->native_calls++;
+
+		#if defined PQ_INSTRUMENT
+			const uint64_t started = stats_now(vm);
+		#endif
+
+		PQ_TRACE_BEGIN(pi->name);
+		PQ_Value ret = pi->fast_proc(vm, &vm->stack[vm->stack_size], pi->arg_count);
+		PQ_TRACE_END(pi->name);
+
+		#if defined PQ_INSTRUMENT
+			stats_count_call(vm, idx, started);
+		#endif
+
+		if (pq_value_is_array(ret))
+		{
+			VM_ERROR("Invalid array return");
+		}
+
+		if (ret.type != VALUE_NULL)
+		{
+			VERIFY_STACK_OVERFLOW();
+
+			vm->stack[vm->stack_size++] = ret;
+		}
+
+		vm->ip++;
+		return;
+	}
+
 	if (vm->call_frame_count >= PQ_MAX_CALL_FRAMES)
 	{
 		VM_ERROR("Call frame overflow");
@@ -200,9 +379,18 @@ static void CALL(PQ_VM* vm, uint16_t idx)
 	PQ_CallFrame* cf = &vm->call_frames[vm->call_frame_count++];
 
 	cf->return_ip = vm->ip + 1;
+	cf->host_call = false;
 	cf->local_base = vm->local_count;
 
+	#if defined PQ_INSTRUMENT
+		cf->proc = idx;
+		cf->started = stats_now(vm);
+	#endif
+
+	cf->scope_base = vm->scope_count;
+
 	cf->scratch = scratch_make(vm->arena);
+	cf->arrays = pool_mark(&vm->arrays);
 
 	if (vm->local_count >= PQ_MAX_LOCALS)
 	{
@@ -245,10 +433,23 @@ static void CALL(PQ_VM* vm, uint16_t idx)
 	{
 		if (!pi->proc)
 		{
-			VM_ERROR("Undefined foreign procedure '%.*s'", s_fmt(pi->foreign_name));
+			if (pi->ordinal == PQ_FOREIGN_UNREGISTERED)
+			{
+				VM_ERROR("Undefined foreign procedure with hash %08x", pi->hash);
+			}
+			else
+			{
+				VM_ERROR("Undefined foreign procedure with ordinal %d", pi->ordinal);
+			}
+
+			return;
 		}
 
+		vm->native_calls++;
+
+		PQ_TRACE_BEGIN(pi->name);
 		pi->proc(vm);
+		PQ_TRACE_END(pi->name);
 
 		VERIFY_STACK_UNDERFLOW();
 
@@ -263,8 +464,9 @@ static void CALL(PQ_VM* vm, uint16_t idx)
 
 		vm->stack_size = cf.stack_base;
 		vm->local_count = cf.local_base;
+		vm->scope_count = cf.scope_base;
 
-		if (ret.type == VALUE_ARRAY)
+		if (pq_value_is_array(ret))
 		{
 			VM_ERROR("Invalid array return");
 		}
@@ -277,6 +479,11 @@ static void CALL(PQ_VM* vm, uint16_t idx)
 		}
 		
 		scratch_release(cf.scratch);
+		pool_release(&vm->arrays, cf.arrays);
+
+		#if defined PQ_INSTRUMENT
+			stats_count_call(vm, idx, cf.started);
+		#endif
 
 		vm->ip++;
 	}
@@ -356,6 +563,37 @@ static void STORE_GLOBAL(PQ_VM* vm, uint16_t idx)
 	vm->ip++;
 }
 
+// stores into variables declared `var <ident>: int`, for values that may not be ints
+static void STORE_LOCAL_INT(PQ_VM* vm, uint16_t idx)
+{
+	idx = get_local_idx(vm, idx);
+
+	if (idx >= PQ_MAX_LOCALS)
+	{
+		VM_ERROR("Local index out of bounds");
+	}
+
+	VERIFY_STACK_UNDERFLOW();
+
+	vm->locals[idx] = pq_value_int(pq_value_as_int(vm->stack[--vm->stack_size]));
+
+	vm->ip++;
+}
+
+static void STORE_GLOBAL_INT(PQ_VM* vm, uint16_t idx)
+{
+	if (idx >= PQ_MAX_GLOBALS)
+	{
+		VM_ERROR("Global index out of bounds");
+	}
+
+	VERIFY_STACK_UNDERFLOW();
+
+	vm->globals[idx] = pq_value_int(pq_value_as_int(vm->stack[--vm->stack_size]));
+
+	vm->ip++;
+}
+
 static void LOAD_LOCAL_SUBSCRIPT(PQ_VM* vm, uint16_t idx)
 {
 	idx = get_local_idx(vm, idx);
@@ -376,7 +614,12 @@ static void LOAD_LOCAL_SUBSCRIPT(PQ_VM* vm, uint16_t idx)
 
 	PQ_Value* array = &vm->locals[idx];
 
-	int32_t sub_idx = (int32_t)pq_value_as_number(idx_v);
+	if (!pq_value_is_array(*array))
+	{
+		VM_ERROR("Invalid local type");
+	}
+
+	int32_t sub_idx = pq_value_as_int(idx_v);
 
 	if (sub_idx >= array->a.count)
 	{
@@ -389,7 +632,7 @@ static void LOAD_LOCAL_SUBSCRIPT(PQ_VM* vm, uint16_t idx)
 
 	VERIFY_STACK_OVERFLOW();
 
-	vm->stack[vm->stack_size++] = array->a.elements[sub_idx];
+	vm->stack[vm->stack_size++] = pq_value_array_get(*array, sub_idx);
 
 	vm->ip++;
 }
@@ -418,12 +661,12 @@ static void STORE_LOCAL_SUBSCRIPT(PQ_VM* vm, uint16_t idx)
 
 	PQ_Value* array = &vm->locals[idx];
 
-	if (array->type != VALUE_ARRAY)
+	if (!pq_value_is_array(*array))
 	{
 		VM_ERROR("Invalid local type");
 	}
 
-	int32_t sub_idx = (int32_t)pq_value_as_number(idx_v);
+	int32_t sub_idx = pq_value_as_int(idx_v);
 
 	if (sub_idx >= array->a.count)
 	{
@@ -434,7 +677,7 @@ static void STORE_LOCAL_SUBSCRIPT(PQ_VM* vm, uint16_t idx)
 		VM_ERROR("Array index out of bounds");
 	}
 
-	array->a.elements[sub_idx] = v;
+	pq_value_array_set(*array, sub_idx, v);
 
 	vm->ip++;
 }
@@ -457,12 +700,12 @@ static void LOAD_GLOBAL_SUBSCRIPT(PQ_VM* vm, uint16_t idx)
 
 	PQ_Value* array = &vm->globals[idx];
 
-	if (array->type != VALUE_ARRAY)
+	if (!pq_value_is_array(*array))
 	{
 		VM_ERROR("Invalid global type");
 	}
 
-	int32_t sub_idx = (int32_t)pq_value_as_number(idx_v);
+	int32_t sub_idx = pq_value_as_int(idx_v);
 
 	if (sub_idx >= array->a.count)
 	{
@@ -475,7 +718,7 @@ static void LOAD_GLOBAL_SUBSCRIPT(PQ_VM* vm, uint16_t idx)
 
 	VERIFY_STACK_OVERFLOW();
 
-	vm->stack[vm->stack_size++] = array->a.elements[sub_idx];
+	vm->stack[vm->stack_size++] = pq_value_array_get(*array, sub_idx);
 
 	vm->ip++;
 }
@@ -502,12 +745,12 @@ static void STORE_GLOBAL_SUBSCRIPT(PQ_VM* vm, uint16_t idx)
 
 	PQ_Value* array = &vm->globals[idx];
 
-	if (array->type != VALUE_ARRAY)
+	if (!pq_value_is_array(*array))
 	{
 		VM_ERROR("Invalid global type");
 	}
 
-	int32_t sub_idx = (int32_t)pq_value_as_number(idx_v);
+	int32_t sub_idx = pq_value_as_int(idx_v);
 
 	if (sub_idx >= array->a.count)
 	{
@@ -518,11 +761,121 @@ static void STORE_GLOBAL_SUBSCRIPT(PQ_VM* vm, uint16_t idx)
 		VM_ERROR("Array index out of bounds");
 	}
 
-	array->a.elements[sub_idx] = v;
+	pq_value_array_set(*array, sub_idx, v);
 
 	vm->ip++;
 }
 
+// the typed subscripts of packed arrays. an int index into an array of the 
+// declared type goes straight to the element, anything else returns false
+// and is left to the generic subscripts, which also report the errors.
+static bool load_packed(PQ_VM* vm, const PQ_Value* array, PQ_ValueType type)
+{
+	if (vm->stack_size == 0)
+	{
+		return false;
+	}
+
+	PQ_Value* top = &vm->stack[vm->stack_size - 1];
+
+	if (array->type != type || top->type != VALUE_INT || (uint32_t)top->i >= array->a.count)
+	{
+		return false;
+	}
+
+	*top = type == VALUE_INT_ARRAY ? pq_value_int(array->a.ints[top->i]) : pq_value_from_pq_number(array->a.numbers[top->i]);
+
+	return true;
+}
+
+static bool store_packed(PQ_VM* vm, PQ_Value* array, PQ_ValueType type)
+{
+	if (vm->stack_size < 2)
+	{
+		return false;
+	}
+
+	const PQ_Value i = vm->stack[vm->stack_size - 1];
+	const PQ_Value v = vm->stack[vm->stack_size - 2];
+
+	if (array->type != type || i.type != VALUE_INT || (uint32_t)i.i >= array->a.count)
+	{
+		return false;
+	}
+
+	if (type == VALUE_INT_ARRAY)
+	{
+		array->a.ints[i.i] = pq_value_as_int(v);
+	}
+	else
+	{
+		array->a.numbers[i.i] = pq_value_as_pq_number(v);
+	}
+
+	vm->stack_size -= 2;
+
+	return true;
+}
+
+#define DEFINE_PACKED_SUBSCRIPT_OPS \
+	OP(INT, VALUE_INT_ARRAY) \
+	OP(NUMBER, VALUE_NUMBER_ARRAY) \
+
+#undef OP
+#define OP(name, type) \
+	static void LOAD_LOCAL_##name##_SUBSCRIPT(PQ_VM* vm, uint16_t idx) \
+	{ \
+		const uint16_t local = get_local_idx(vm, idx); \
+		\
+		if (local < PQ_MAX_LOCALS && load_packed(vm, &vm->locals[local], type)) \
+		{ \
+			vm->ip++; \
+			return; \
+		} \
+		\
+		LOAD_LOCAL_SUBSCRIPT(vm, idx); \
+	} \
+	\
+	static void STORE_LOCAL_##name##_SUBSCRIPT(PQ_VM* vm, uint16_t idx) \
+	{ \
+		const uint16_t local = get_local_idx(vm, idx); \
+		\
+		if (local < PQ_MAX_LOCALS && store_packed(vm, &vm->locals[local], type)) \
+		{ \
+			vm->ip++; \
+			return; \
+		} \
+		\
+		STORE_LOCAL_SUBSCRIPT(vm, idx); \
+	} \
+	\
+	static void LOAD_GLOBAL_##name##_SUBSCRIPT(PQ_VM* vm, uint16_t idx) \
+	{ \
+		if (idx < PQ_MAX_GLOBALS && load_packed(vm, &vm->globals[idx], type)) \
+		{ \
+			vm->ip++; \
+			return; \
+		} \
+		\
+		LOAD_GLOBAL_SUBSCRIPT(vm, idx); \
+	} \
+	\
+	static void STORE_GLOBAL_##name##_SUBSCRIPT(PQ_VM* vm, uint16_t idx) \
+	{ \
+		if (idx < PQ_MAX_GLOBALS && store_packed(vm, &vm->globals[idx], type)) \
+		{ \
+			vm->ip++; \
+			return; \
+		} \
+		\
+		STORE_GLOBAL_SUBSCRIPT(vm, idx); \
+	}
+
+DEFINE_PACKED_SUBSCRIPT_OPS
+
+#undef OP
+#undef DEFINE_PACKED_SUBSCRIPT_OPS
+
 static void JUMP(PQ_VM* vm, uint16_t to)
 {
 	if (to >= vm->instruction_count)
@@ -554,21 +907,93 @@ static void LOAD_NULL(PQ_VM* vm)
 	vm->ip++;
 }
 
-// TODO: arrays are the only values that get allocated dynamically at runtime. 
-//       they get cleaned up upon leaving a call frame, however, scopes don't 
-//       do this at the moment.
-static void LOAD_ARRAY(PQ_VM* vm, uint16_t size)
+// arrays are the only values that get allocated dynamically at runtime. 
+// they get recycled upon leaving a call frame, or a loop body (see ENTER_SCOPE).
+// packed ones take 4 bytes per element instead of a whole PQ_Value.
+static void load_array(PQ_VM* vm, PQ_ValueType type, uint16_t size, bool zero)
 {
-	if (vm->arena->offset + (size * sizeof(PQ_Value)) > vm->arena->capacity)
+	size_t element_size = type == VALUE_ARRAY ? sizeof(PQ_Value) : sizeof(int32_t);
+
+	void* elements = pool_alloc(&vm->arrays, size * element_size, zero);
+
+	if (!elements)
 	{
 		VM_ERROR("Out of memory");
+		return;
 	}
 
-	PQ_Value array = pq_value_array(vm->arena, size);
-	
 	VERIFY_STACK_OVERFLOW();
 
-	vm->stack[vm->stack_size++] = array;
+	vm->stack[vm->stack_size++] = (PQ_Value){ type, .a = { .elements = elements, .count = size } };
+
+	vm->ip++;
+}
+
+static void LOAD_ARRAY(PQ_VM* vm, uint16_t size)
+{
+	load_array(vm, VALUE_ARRAY, size, true);
+}
+
+// the compiler made sure every element gets written before being read
+static void LOAD_ARRAY_UNINIT(PQ_VM* vm, uint16_t size)
+{
+	load_array(vm, VALUE_ARRAY, size, false);
+}
+
+static void LOAD_INT_ARRAY(PQ_VM* vm, uint16_t size)
+{
+	load_array(vm, VALUE_INT_ARRAY, size, true);
+}
+
+static void LOAD_NUMBER_ARRAY(PQ_VM* vm, uint16_t size)
+{
+	load_array(vm, VALUE_NUMBER_ARRAY, size, true);
+}
+
+static uint16_t get_scope_idx(PQ_VM* vm, uint16_t depth)
+{
+	if (vm->call_frame_count > 0)
+	{
+		const PQ_CallFrame* cf = &vm->call_frames[vm->call_frame_count - 1];
+
+		depth = cf->scope_base + depth;
+	}
+
+	return depth;
+}
+
+// scope markers are addressed by depth rather than pushed and popped, 
+// so jumping out of a scope without leaving it (e.g. when a loop condition
+// fails) can't unbalance anything. entering a scope forgets the ones nested 
+// in it, leaving a scope releases every array allocated since it was entered.
+static void ENTER_SCOPE(PQ_VM* vm, uint16_t depth)
+{
+	uint16_t idx = get_scope_idx(vm, depth);
+
+	if (idx >= PQ_MAX_SCOPES)
+	{
+		VM_ERROR("Scope overflow");
+		return;
+	}
+
+	vm->scope_marks[idx] = pool_mark(&vm->arrays);
+	vm->scope_count = idx + 1;
+
+	vm->ip++;
+}
+
+static void LEAVE_SCOPE(PQ_VM* vm, uint16_t depth)
+{
+	uint16_t idx = get_scope_idx(vm, depth);
+
+	if (idx >= vm->scope_count)
+	{
+		VM_ERROR("Scope underflow");
+		return;
+	}
+
+	pool_release(&vm->arrays, vm->scope_marks[idx]);
+	vm->scope_count = idx;
 
 	vm->ip++;
 }
@@ -592,6 +1017,15 @@ static void LOAD_ARRAY(PQ_VM* vm, uint16_t size)
 	OP(BW_XOR, bw_xor) \
 	OP(BW_LEFT_SHIFT, bw_left_shift) \
 	OP(BW_RIGHT_SHIFT, bw_right_shift) \
+	OP(ADD_INT, add_int) \
+	OP(SUB_INT, sub_int) \
+	OP(MUL_INT, mul_int) \
+	OP(MOD_INT, mod_int) \
+	OP(GREATER_THAN_INT, gt_int) \
+	OP(LESS_THAN_INT, lt_int) \
+	OP(EQUALS_INT, equals_int) \
+	OP(GREATER_INT, greater_int) \
+	OP(LESS_INT, less_int) \
 
 #define OP(name, op) \
 	static void name(PQ_VM* vm) \
@@ -635,11 +1069,42 @@ static void NEGATE(PQ_VM* vm)
 
 	VERIFY_STACK_OVERFLOW();
 
-	vm->stack[vm->stack_size++] = pq_value_mul(l, pq_value_number(-1.0f));
+	vm->stack[vm->stack_size++] = pq_value_mul(l, pq_value_int(-1));
 
 	vm->ip++;
 }
 
+// math intrinsics, compiled from calls like `sin(x)` instead of a CALL
+#define DEFINE_MATH_OPS \
+	OP(ABS, abs) \
+	OP(FLOOR, floor) \
+	OP(CEIL, ceil) \
+	OP(SQRT, sqrt) \
+	OP(SIN, sin) \
+	OP(COS, cos) \
+	OP(TAN, tan) \
+	OP(ATAN, atan) \
+
+#undef OP
+#define OP(name, op) \
+	static void name(PQ_VM* vm) \
+	{ \
+		VERIFY_STACK_UNDERFLOW(); \
+		\
+		PQ_Value l = vm->stack[--vm->stack_size]; \
+		\
+		VERIFY_STACK_OVERFLOW(); \
+		\
+		vm->stack[vm->stack_size++] = pq_value_from_pq_number(pq_math_##op(pq_value_as_pq_number(l))); \
+		\
+		vm->ip++; \
+	}
+
+DEFINE_MATH_OPS
+
+#undef OP
+#undef DEFINE_MATH_OPS
+
 static void RETURN(PQ_VM* vm)
 {
 	VERIFY_STACK_UNDERFLOW();
@@ -655,8 +1120,9 @@ static void RETURN(PQ_VM* vm)
 
 	vm->stack_size = cf.stack_base;
 	vm->local_count = cf.local_base;
+	vm->scope_count = cf.scope_base;
 
-	if (ret.type == VALUE_ARRAY)
+	if (pq_value_is_array(ret))
 	{
 		VM_ERROR("Invalid array return");
 	}
@@ -669,6 +1135,11 @@ static void RETURN(PQ_VM* vm)
 	}
 
 	scratch_release(cf.scratch);
+	pool_release(&vm->arrays, cf.arrays);
+
+	#if defined PQ_INSTRUMENT
+		stats_count_call(vm, cf.proc, cf.started);
+	#endif
 
 	vm->ip = cf.return_ip;
 }
@@ -678,30 +1149,58 @@ static void HALT(PQ_VM* vm)
 	vm->stack_size = 0;
 	vm->local_count = 0;
 	vm->call_frame_count = 0;
+	vm->scope_count = 0;
 
 	vm->halt = true;
 }
 
 void pq_vm_init(PQ_VM* vm, Arena* arena, const PQ_CompiledBlob* b, PQ_VMErrorFn error)
 {
-	if (b->size > PQ_MAX_BLOB_SIZE)
+	vm->arena = arena;
+
+	vm->error = error;
+
+	if (b->size > PQ_MAX_BLOB_SIZE + PQ_MAX_DEBUG_INFO_SIZE)
 	{
 		VM_ERROR("Provided blob is too big");
+		return;
 	}
 
-	vm->arena = arena;
+	PQ_TRACE_BEGIN(s("pq_vm_init"));
 
-	vm->error = error;
+	ArenaTag tag = arena_set_tag(arena, ARENA_TAG_VM_STACK);
+
+	// all of these are only read below their counts
+	vm->call_frames = arena_push_array_uninit(arena, PQ_CallFrame, PQ_MAX_CALL_FRAMES);
+	vm->stack = arena_push_array_uninit(arena, PQ_Value, PQ_MAX_STACK_SIZE);
+	vm->locals = arena_push_array_uninit(arena, PQ_Value, PQ_MAX_LOCALS);
+	vm->scope_marks = arena_push_array_uninit(arena, PoolBlock*, PQ_MAX_SCOPES);
+
+	arena_set_tag(arena, tag);
 
-	vm->call_frames = arena_push_array(arena, PQ_CallFrame, PQ_MAX_CALL_FRAMES);
-	vm->stack = arena_push_array(arena, PQ_Value, PQ_MAX_STACK_SIZE);
-	vm->locals = arena_push_array(arena, PQ_Value, PQ_MAX_LOCALS);
+	// arrays take whatever the arena has left, as they're allocated
+	vm->arrays = pool_make(arena);
 
 	vm->bp = 0;
 
+	vm->instructions_executed = 0;
+	vm->native_calls = 0;
+
+	#if defined PQ_PROFILE
+		vm->profiler = nullptr;
+	#endif
+
+	#if defined PQ_INSTRUMENT
+		vm->stats = nullptr;
+	#endif
+
+	PQ_TRACE_BEGIN(s("read_blob"));
 	read_blob(vm, b);
+	PQ_TRACE_END(s("read_blob"));
 
 	vm->halt = false;
+
+	PQ_TRACE_END(s("pq_vm_init"));
 }
 
 bool pq_execute(PQ_VM* vm)
@@ -713,6 +1212,19 @@ bool pq_execute(PQ_VM* vm)
 
 	PQ_Instruction it = vm->instructions[vm->ip];
 
+	vm->instructions_executed++;
+
+	#if defined PQ_PROFILE
+		if (vm->profiler && --vm->profiler->countdown == 0)
+		{
+			pq_profiler_sample(vm->profiler, vm);
+		}
+	#endif
+
+	#if defined PQ_INSTRUMENT
+		const uint64_t started = stats_now(vm);
+	#endif
+
 	switch (it.type)
 	{
 		case INST_CALL:                   CALL(vm, it.arg); break;
@@ -721,11 +1233,28 @@ bool pq_execute(PQ_VM* vm)
 		case INST_STORE_LOCAL:            STORE_LOCAL(vm, it.arg); break;
 		case INST_LOAD_GLOBAL:            LOAD_GLOBAL(vm, it.arg); break;
 		case INST_STORE_GLOBAL:           STORE_GLOBAL(vm, it.arg); break;
+		case INST_STORE_LOCAL_INT:        STORE_LOCAL_INT(vm, it.arg); break;
+		case INST_STORE_GLOBAL_INT:       STORE_GLOBAL_INT(vm, it.arg); break;
 		case INST_LOAD_LOCAL_SUBSCRIPT:   LOAD_LOCAL_SUBSCRIPT(vm, it.arg); break;
 		case INST_STORE_LOCAL_SUBSCRIPT:  STORE_LOCAL_SUBSCRIPT(vm, it.arg); break;
 		case INST_LOAD_GLOBAL_SUBSCRIPT:  LOAD_GLOBAL_SUBSCRIPT(vm, it.arg); break;
 		case INST_STORE_GLOBAL_SUBSCRIPT: STORE_GLOBAL_SUBSCRIPT(vm, it.arg); break;
+
+		case INST_LOAD_LOCAL_INT_SUBSCRIPT:      LOAD_LOCAL_INT_SUBSCRIPT(vm, it.arg); break;
+		case INST_STORE_LOCAL_INT_SUBSCRIPT:     STORE_LOCAL_INT_SUBSCRIPT(vm, it.arg); break;
+		case INST_LOAD_GLOBAL_INT_SUBSCRIPT:     LOAD_GLOBAL_INT_SUBSCRIPT(vm, it.arg); break;
+		case INST_STORE_GLOBAL_INT_SUBSCRIPT:    STORE_GLOBAL_INT_SUBSCRIPT(vm, it.arg); break;
+		case INST_LOAD_LOCAL_NUMBER_SUBSCRIPT:   LOAD_LOCAL_NUMBER_SUBSCRIPT(vm, it.arg); break;
+		case INST_STORE_LOCAL_NUMBER_SUBSCRIPT:  STORE_LOCAL_NUMBER_SUBSCRIPT(vm, it.arg); break;
+		case INST_LOAD_GLOBAL_NUMBER_SUBSCRIPT:  LOAD_GLOBAL_NUMBER_SUBSCRIPT(vm, it.arg); break;
+		case INST_STORE_GLOBAL_NUMBER_SUBSCRIPT: STORE_GLOBAL_NUMBER_SUBSCRIPT(vm, it.arg); break;
+
 		case INST_LOAD_ARRAY:             LOAD_ARRAY(vm, it.arg); break;
+		case INST_LOAD_ARRAY_UNINIT:      LOAD_ARRAY_UNINIT(vm, it.arg); break;
+		case INST_LOAD_INT_ARRAY:         LOAD_INT_ARRAY(vm, it.arg); break;
+		case INST_LOAD_NUMBER_ARRAY:      LOAD_NUMBER_ARRAY(vm, it.arg); break;
+		case INST_ENTER_SCOPE:            ENTER_SCOPE(vm, it.arg); break;
+		case INST_LEAVE_SCOPE:            LEAVE_SCOPE(vm, it.arg); break;
 		case INST_JUMP:                   JUMP(vm, it.arg); break;
 		case INST_JUMP_COND:              JUMP_COND(vm, it.arg); break;
 		case INST_LOAD_NULL:              LOAD_NULL(vm); break;
@@ -741,8 +1270,25 @@ bool pq_execute(PQ_VM* vm)
 		case INST_EQUALS:                 EQUALS(vm); break;
 		case INST_GREATER:                GREATER(vm); break;
 		case INST_LESS:                   LESS(vm); break;
+		case INST_ADD_INT:                ADD_INT(vm); break;
+		case INST_SUB_INT:                SUB_INT(vm); break;
+		case INST_MUL_INT:                MUL_INT(vm); break;
+		case INST_MOD_INT:                MOD_INT(vm); break;
+		case INST_GREATER_THAN_INT:       GREATER_THAN_INT(vm); break;
+		case INST_LESS_THAN_INT:          LESS_THAN_INT(vm); break;
+		case INST_EQUALS_INT:             EQUALS_INT(vm); break;
+		case INST_GREATER_INT:            GREATER_INT(vm); break;
+		case INST_LESS_INT:               LESS_INT(vm); break;
 		case INST_NOT:                    NOT(vm); break;
 		case INST_NEGATE:                 NEGATE(vm); break;
+		case INST_ABS:                    ABS(vm); break;
+		case INST_FLOOR:                  FLOOR(vm); break;
+		case INST_CEIL:                   CEIL(vm); break;
+		case INST_SQRT:                   SQRT(vm); break;
+		case INST_SIN:                    SIN(vm); break;
+		case INST_COS:                    COS(vm); break;
+		case INST_TAN:                    TAN(vm); break;
+		case INST_ATAN:                   ATAN(vm); break;
 		case INST_BW_OR:                  BW_OR(vm); break;
 		case INST_BW_AND:                 BW_AND(vm); break;
 		case INST_BW_XOR:                 BW_XOR(vm); break;
@@ -754,9 +1300,97 @@ bool pq_execute(PQ_VM* vm)
 		default: VM_ERROR("Illegal instruction %d", it.type);
 	}
 
+	#if defined PQ_INSTRUMENT
+		if (vm->stats && it.type < INST_COUNT)
+		{
+			stats_count(vm, &vm->stats->instructions[it.type], started);
+		}
+	#endif
+
 	return !vm->halt;
 }
 
+bool pq_vm_call(PQ_VM* vm, uint16_t idx, const PQ_Value* args, uint16_t arg_count)
+{
+	// the procedure returns to the HALT the program stopped at, which halts it again
+	const uint16_t halt_ip = vm->ip;
+
+	if (!vm->halt || halt_ip >= vm->instruction_count || vm->instructions[halt_ip].type != INST_HALT)
+	{
+		VM_ERROR("Procedures can only be called once the program halted");
+		return false;
+	}
+
+	if (idx >= vm->proc_info_count || vm->proc_infos[idx].foreign || vm->proc_infos[idx].arg_count != arg_count)
+	{
+		VM_ERROR("Invalid procedure %d called from the host", idx);
+		return false;
+	}
+
+	if (vm->stack_size + arg_count > PQ_MAX_STACK_SIZE)
+	{
+		VM_ERROR("Stack overflow");
+		return false;
+	}
+
+	for (uint16_t i = 0; i < arg_count; i++)
+	{
+		vm->stack[vm->stack_size++] = args[i];
+	}
+
+	vm->halt = false;
+
+	CALL(vm, idx);
+
+	vm->call_frames[vm->call_frame_count - 1].return_ip = halt_ip;
+	vm->call_frames[vm->call_frame_count - 1].host_call = true;
+
+	return !vm->halt;
+}
+
+uint16_t pq_vm_line_at(const PQ_VM* vm, uint16_t ip)
+{
+	if (vm->line_run_count == 0 || ip < vm->line_runs[0].first_inst)
+	{
+		return 0;
+	}
+
+	// the last run starting at or before `ip`
+	uint16_t lo = 0;
+	uint16_t hi = vm->line_run_count;
+
+	while (hi - lo > 1)
+	{
+		const uint16_t mid = lo + (hi - lo) / 2;
+
+		if (vm->line_runs[mid].first_inst <= ip)
+		{
+			lo = mid;
+		}
+		else
+		{
+			hi = mid;
+		}
+	}
+
+	return vm->line_runs[lo].line;
+}
+
+uint16_t pq_vm_procedure_at(const PQ_VM* vm, uint16_t ip)
+{
+	for (uint16_t i = 0; i < vm->proc_info_count; i++)
+	{
+		const PQ_ProcedureInfo* pi = &vm->proc_infos[i];
+
+		if (!pi->foreign && ip >= pi->first_inst && ip < pi->last_inst)
+		{
+			return i;
+		}
+	}
+
+	return PQ_NO_PROCEDURE;
+}
+
 PQ_Value pq_vm_get_local(PQ_VM* vm, uint16_t idx)
 {
 	return vm->locals[get_local_idx(vm, idx)];
@@ -774,13 +1408,157 @@ void pq_vm_push(PQ_VM* vm, PQ_Value v)
 
 void pq_vm_bind_foreign_proc(PQ_VM* vm, String name, PQ_NativeProcedure proc)
 {
+	uint32_t hash = pq_foreign_hash(name);
+
 	for (uint16_t i = 0; i < vm->proc_info_count; i++)
 	{
 		PQ_ProcedureInfo* pi = &vm->proc_infos[i];
 
-		if (str_equals(name, pi->foreign_name))
+		if (pi->foreign && pi->ordinal == PQ_FOREIGN_UNREGISTERED && pi->hash == hash)
 		{
 			pi->proc = proc;
 		}
 	}
-}
\ No newline at end of file
+}
+
+void pq_vm_bind_fast_foreign_proc(PQ_VM* vm, String name, PQ_FastNativeProcedure proc)
+{
+	uint32_t hash = pq_foreign_hash(name);
+
+	for (uint16_t i = 0; i < vm->proc_info_count; i++)
+	{
+		PQ_ProcedureInfo* pi = &vm->proc_infos[i];
+
+		if (pi->foreign && pi->ordinal == PQ_FOREIGN_UNREGISTERED && pi->hash == hash)
+		{
+			pi->fast_proc = proc;
+		}
+	}
+}
+
+void pq_vm_bind_foreign_registry(PQ_VM* vm, const PQ_ForeignRegistry* registry)
+{
+	for (uint16_t i = 0; i < vm->proc_info_count; i++)
+	{
+		PQ_ProcedureInfo* pi = &vm->proc_infos[i];
+
+		if (!pi->foreign || pi->ordinal == PQ_FOREIGN_UNREGISTERED)
+		{
+			continue;
+		}
+
+		if (vm->registry_version != registry->version)
+		{
+			VM_ERROR("Program was compiled against version %d of the foreign procedures, not %d", vm->registry_version, registry->version);
+			return;
+		}
+
+		if (pi->ordinal >= registry->proc_count || pi->arg_count != registry->procs[pi->ordinal].arg_count)
+		{
+			VM_ERROR("Invalid foreign procedure ordinal %d", pi->ordinal);
+			return;
+		}
+
+		pi->fast_proc = registry->procs[pi->ordinal].proc;
+	}
+}
+
+void pq_vm_error(PQ_VM* vm, const char* what)
+{
+	vm->halt = true;
+	vm->error(what);
+}
+
+#if defined PQ_INSTRUMENT
+	void pq_vm_attach_stats(PQ_VM* vm, PQ_VMStats* stats, PQ_CycleFn cycles)
+	{
+		*stats = (PQ_VMStats){};
+
+		stats->cycles = cycles;
+
+		vm->stats = stats;
+	}
+
+	// writes the indices of the counters that ran into `order`, the most cycles first
+	static uint16_t sort_counters(const PQ_Counter* counters, uint16_t count, uint16_t* order)
+	{
+		uint16_t n = 0;
+
+		for (uint16_t i = 0; i < count; i++)
+		{
+			if (counters[i].count == 0)
+			{
+				continue;
+			}
+
+			uint16_t j = n++;
+
+			for (; j > 0 && counters[order[j - 1]].cycles < counters[i].cycles; j--)
+			{
+				order[j] = order[j - 1];
+			}
+
+			order[j] = i;
+		}
+
+		return n;
+	}
+
+	static void write_counter(PQ_VMStatsFn out, const char* name, const PQ_Counter* c)
+	{
+		char line[256];
+
+		sprintf(line, "  %-25.25s | %-10llu | %-14llu | %-10llu\n", name, (unsigned long long)c->count, (unsigned long long)c->cycles, (unsigned long long)(c->cycles / c->count));
+
+		out(line);
+	}
+
+	void pq_vm_write_stats(const PQ_VM* vm, PQ_VMStatsFn out)
+	{
+		const PQ_VMStats* stats = vm->stats;
+
+		if (!stats)
+		{
+			return;
+		}
+
+		char line[256];
+
+		// there are fewer instruction types than that
+		uint16_t order[PQ_MAX_PROCEDURES];
+
+		sprintf(line, "  %-25s | %-10s | %-14s | %-10s\n", "instruction", "count", "cycles", "per run");
+		out(line);
+
+		const uint16_t instruction_count = sort_counters(stats->instructions, INST_COUNT, order);
+
+		for (uint16_t i = 0; i < instruction_count; i++)
+		{
+			write_counter(out, pq_inst_to_c_str(order[i]), &stats->instructions[order[i]]);
+		}
+
+		sprintf(line, "\n  %-25s | %-10s | %-14s | %-10s\n", "procedure", "calls", "cycles", "per call");
+		out(line);
+
+		const uint16_t procedure_count = sort_counters(stats->procedures, vm->proc_info_count, order);
+
+		for (uint16_t i = 0; i < procedure_count; i++)
+		{
+			const PQ_ProcedureInfo* pi = &vm->proc_infos[order[i]];
+
+			// foreign ones are marked, names only come with debug info
+			char name[64];
+
+			if (pi->name.length > 0)
+			{
+				sprintf(name, "%s%.*s", pi->foreign ? "foreign " : "", (int)MIN(pi->name.length, (size_t)40), pi->name.buffer);
+			}
+			else
+			{
+				sprintf(name, "%s#%d", pi->foreign ? "foreign " : "", order[i]);
+			}
+
+			write_counter(out, name, &stats->procedures[order[i]]);
+		}
+	}
+#endif
@@ -7,6 +7,39 @@
 #include <pq/config.h>
 
 typedef struct PQ_VM PQ_VM;
+typedef struct PQ_Profiler PQ_Profiler;
+
+//
+// instrumentation
+//
+// when built with PQ_INSTRUMENT, a vm with stats attached counts every 
+// instruction it runs by type, and every call by procedure (foreign ones 
+// included), along with the time they took. calls include their callees. 
+// without PQ_INSTRUMENT none of it is compiled in.
+//
+
+#if defined PQ_INSTRUMENT
+	// a timestamp in any unit, cpu cycles ideally
+	typedef uint64_t (*PQ_CycleFn)(void);
+
+	typedef struct PQ_Counter PQ_Counter;
+	struct PQ_Counter
+	{
+		uint64_t count;
+		uint64_t cycles;
+	};
+
+	typedef struct PQ_VMStats PQ_VMStats;
+	struct PQ_VMStats
+	{
+		PQ_CycleFn cycles;
+
+		PQ_Counter instructions[INST_COUNT];
+
+		// by index, like PQ_VM.proc_infos
+		PQ_Counter procedures[PQ_MAX_PROCEDURES];
+	};
+#endif
 
 typedef struct PQ_CallFrame PQ_CallFrame;
 struct PQ_CallFrame
@@ -15,8 +48,18 @@ struct PQ_CallFrame
 
 	uint16_t stack_base;
 	uint16_t local_base;
+	uint16_t scope_base;
 
 	Scratch scratch;
+	PoolBlock* arrays;
+
+	// made by pq_vm_call, rather than by a CALL of the program
+	bool host_call;
+
+	#if defined PQ_INSTRUMENT
+		uint16_t proc;
+		uint64_t started;
+	#endif
 };
 
 typedef void (*PQ_NativeProcedure)(PQ_VM* vm);
@@ -31,8 +74,24 @@ struct PQ_ProcedureInfo
 
 	uint16_t first_inst;
 
-	String foreign_name;
+	// PQ_FOREIGN_UNREGISTERED if bound by name hash
+	uint16_t ordinal;
+	uint32_t hash;
+
 	PQ_NativeProcedure proc;
+	PQ_FastNativeProcedure fast_proc;
+
+	// from the debug info, empty without it. the body ends before `last_inst`.
+	String name;
+	uint16_t last_inst;
+};
+
+// where the instructions from `first_inst` on, up to the next run, came from
+typedef struct PQ_LineRun PQ_LineRun;
+struct PQ_LineRun
+{
+	uint16_t first_inst;
+	uint16_t line;
 };
 
 typedef void (*PQ_VMErrorFn)(const char*);
@@ -41,6 +100,10 @@ struct PQ_VM
 {
 	Arena* arena;
 
+	// arrays are carved from the top of the arena, apart from everything else
+	// in it, so they can be recycled
+	Pool arrays;
+
 	PQ_VMErrorFn error;
 
 	PQ_Value* immediates;
@@ -48,10 +111,19 @@ struct PQ_VM
 
 	PQ_ProcedureInfo* proc_infos;
 	uint16_t proc_info_count;
+	uint16_t registry_version;
+
+	// PQ_NO_PROCEDURE unless the program defines them, see PQ_ProcedureFlags
+	uint16_t update_proc;
+	uint16_t draw_proc;
 
 	PQ_Instruction* instructions;
 	uint16_t instruction_count;
 
+	// from the debug info, none without it
+	PQ_LineRun* line_runs;
+	uint16_t line_run_count;
+
 	PQ_CallFrame* call_frames;
 	uint16_t call_frame_count;
 
@@ -64,16 +136,46 @@ struct PQ_VM
 	PQ_Value* globals;
 	uint16_t global_count;
 
+	// arrays to release when leaving a scope, see PQ_Scope
+	PoolBlock** scope_marks;
+	uint16_t scope_count;
+
 	bool halt;
 
 	uint16_t ip;
 	uint16_t bp;
+
+	// running totals for the host's statistics, they wrap around
+	uint32_t instructions_executed;
+	uint32_t native_calls;
+
+	// samples the call stack while set, see PQ_Profiler. only built with 
+	// PQ_PROFILE, so other builds don't check for it on every instruction.
+	#if defined PQ_PROFILE
+		PQ_Profiler* profiler;
+	#endif
+
+	#if defined PQ_INSTRUMENT
+		PQ_VMStats* stats;
+	#endif
 };
 
 void pq_vm_init(PQ_VM* vm, Arena* arena, const PQ_CompiledBlob* b, PQ_VMErrorFn error);
 
 bool pq_execute(PQ_VM* vm);
 
+// calls procedure `idx` from the host, once the program has halted. pq_execute 
+// then runs it, and returns false as soon as it returns. returns false if 
+// the call can't be made.
+bool pq_vm_call(PQ_VM* vm, uint16_t idx, const PQ_Value* args, uint16_t arg_count);
+
+// the source line of the instruction at `ip`, 0 without debug info
+uint16_t pq_vm_line_at(const PQ_VM* vm, uint16_t ip);
+
+// the procedure whose body holds the instruction at `ip`. PQ_NO_PROCEDURE for 
+// top level code, or without debug info.
+uint16_t pq_vm_procedure_at(const PQ_VM* vm, uint16_t ip);
+
 PQ_Value pq_vm_get_local(PQ_VM* vm, uint16_t index);
 
 PQ_Value pq_vm_pop(PQ_VM* vm);
@@ -82,6 +184,26 @@ void pq_vm_push(PQ_VM* vm, PQ_Value v);
 
 void pq_vm_bind_foreign_proc(PQ_VM* vm, String name, PQ_NativeProcedure proc);
 
+void pq_vm_bind_fast_foreign_proc(PQ_VM* vm, String name, PQ_FastNativeProcedure proc);
+
+// binds every procedure the blob refers to by ordinal, the registry has to be 
+// the same version the program was compiled against
+void pq_vm_bind_foreign_registry(PQ_VM* vm, const PQ_ForeignRegistry* registry);
+
+// raises a runtime error from a foreign procedure and halts the VM. 
+// the procedure still has to return.
+void pq_vm_error(PQ_VM* vm, const char* what);
+
+#if defined PQ_INSTRUMENT
+	// counts from then on, into `stats`, which gets cleared
+	void pq_vm_attach_stats(PQ_VM* vm, PQ_VMStats* stats, PQ_CycleFn cycles);
+
+	typedef void (*PQ_VMStatsFn)(const char*);
+
+	// one line per instruction type and per procedure that ran, the busiest first
+	void pq_vm_write_stats(const PQ_VM* vm, PQ_VMStatsFn out);
+#endif
+
 //
 // helpers
 //
@@ -2,6 +2,102 @@
 
 #include <third_party/font8x8_basic.h>
 
+//
+// glyph atlas
+//
+
+// each glyph of the font is decomposed into a handful of solid rectangles 
+// (in font units), so drawing text at any scale is just a few span fills per
+// glyph instead of a put per set bit. the decomposition doesn't depend on 
+// the scale, so one atlas serves every text size.
+static constexpr uint8_t RT_MAX_GLYPH_RECTS = 12;
+
+typedef struct RT_GlyphRect RT_GlyphRect;
+struct RT_GlyphRect
+{
+	uint8_t x : 4;
+	uint8_t w : 4;
+	uint8_t y : 4;
+	uint8_t h : 4;
+};
+
+typedef struct RT_Glyph RT_Glyph;
+struct RT_Glyph
+{
+	RT_GlyphRect rects[RT_MAX_GLYPH_RECTS];
+	uint8_t rect_count;
+};
+
+static RT_Glyph glyph_atlas[COUNT_OF(font8x8_basic)];
+static bool glyph_atlas_built = false;
+
+static uint8_t glyph_run_mask(uint8_t x, uint8_t w)
+{
+	return (uint8_t)(((1u << w) - 1) << x);
+}
+
+// true if row `y` of `bits` has a run exactly spanning [x, x + w)
+static bool glyph_has_run(const char* bits, uint8_t y, uint8_t x, uint8_t w)
+{
+	const uint8_t row = (uint8_t)bits[y];
+	const uint8_t run = glyph_run_mask(x, w);
+
+	// include the neighbouring columns so we only match runs that have the same bounds
+	const uint8_t bounds = run | (uint8_t)(run << 1) | (uint8_t)(run >> 1);
+
+	return (row & bounds) == run;
+}
+
+static void build_glyph(RT_Glyph* g, const char* bits)
+{
+	// rows that were already covered by a rect extended from above
+	uint8_t covered[8] = {};
+
+	for (uint8_t y = 0; y < 8; y++)
+	{
+		uint8_t row = (uint8_t)bits[y] & ~covered[y];
+
+		while (row)
+		{
+			const uint8_t x = __builtin_ctz(row);
+			const uint8_t w = __builtin_ctz(~(uint32_t)(row >> x));
+
+			row &= ~glyph_run_mask(x, w);
+
+			uint8_t h = 1;
+
+			while (y + h < 8 && glyph_has_run(bits, y + h, x, w))
+			{
+				covered[y + h] |= glyph_run_mask(x, w);
+				h++;
+			}
+
+			ASSERT(g->rect_count < RT_MAX_GLYPH_RECTS);
+
+			g->rects[g->rect_count++] = (RT_GlyphRect){ x, w, y, h };
+		}
+	}
+}
+
+static void build_glyph_atlas()
+{
+	if (glyph_atlas_built)
+	{
+		return;
+	}
+
+	glyph_atlas_built = true;
+
+	for (size_t i = 0; i < COUNT_OF(font8x8_basic); i++)
+	{
+		build_glyph(&glyph_atlas[i], font8x8_basic[i]);
+	}
+}
+
+//
+// canvas
+//
+
 RT_Canvas rt_canvas_make(Arena* arena, uint16_t width, uint16_t height)
 {
 	RT_Canvas c = {};
@@ -10,16 +106,30 @@ RT_Canvas rt_canvas_make(Arena* arena, uint16_t width, uint16_t height)
 	c.height = height;
 
 	#if !defined PICO_RP2040
-		c.back_buffer = arena_push_array(arena, uint8_t, c.width * c.height);
-		c.frame_buffer = arena_push_array(arena, uint8_t, c.width * c.height);
+		ArenaTag tag = arena_set_tag(arena, ARENA_TAG_CANVAS);
+
+		// both get written below
+		c.back_buffer = arena_push_array_uninit(arena, uint8_t, c.width * c.height);
+		c.frame_buffer = arena_push_array_uninit(arena, uint8_t, c.width * c.height);
+
+		arena_set_tag(arena, tag);
 	#endif
 	
 	c.back_color = 0x00;
 	c.fore_color = 0xff;
 
 	c.line_width = 1;
+	c.shade = 16;
+
+	c.clip_top = 0;
+	c.clip_bottom = c.height;
+
+	build_glyph_atlas();
 
 	rt_canvas_clear(&c);
+	rt_canvas_present(&c);
+
+	c.pixels = 0;
 
 	return c;
 }
@@ -41,10 +151,12 @@ RT_Canvas rt_canvas_make(Arena* arena, uint16_t width, uint16_t height)
 
 void rt_canvas_clear(RT_Canvas* c)
 {
+	c->pixels += c->width * (c->clip_bottom - c->clip_top);
+
 	#if defined PICO_RP2040
 		lcd_fill_screen(r3g3b2_to_r5g6b5(c->back_color));
 	#else
-		__builtin_memset(c->back_buffer, c->back_color, c->width * c->height);
+		__builtin_memset(c->back_buffer + c->clip_top * c->width, c->back_color, c->width * (c->clip_bottom - c->clip_top));
 	#endif
 }
 
@@ -125,13 +237,25 @@ void rt_canvas_fill_rect(RT_Canvas* c, int16_t x, int16_t y, int16_t w, int16_t
 		const uint16_t cc = r3g3b2_to_r5g6b5(c->fore_color);
 
 		lcd_fill_rect(x, y, w, h, cc);
+
+		c->pixels += MAX(w * h, 0);
 	#else
-		for (int16_t i = x; i < x + w; i++) 
+		int16_t x0 = MAX(x, (int16_t)0);
+		int16_t y0 = MAX(y, c->clip_top);
+		int16_t x1 = MIN((int16_t)(x + w), (int16_t)c->width);
+		int16_t y1 = MIN((int16_t)(y + h), c->clip_bottom);
+
+		if (x0 >= x1 || y0 >= y1)
 		{
-			for (int16_t j = y; j < y + h; j++) 
-			{
-				rt_canvas_put(c, i, j);
-			}
+			return;
+		}
+
+		c->pixels += (x1 - x0) * (y1 - y0);
+
+		// one span per row
+		for (int16_t j = y0; j < y1; j++) 
+		{
+			__builtin_memset(c->back_buffer + x0 + j * c->width, c->fore_color, x1 - x0);
 		}
 	#endif
 }
@@ -142,10 +266,13 @@ void rt_canvas_put(RT_Canvas* c, int16_t x, int16_t y)
 		const uint16_t cc = r3g3b2_to_r5g6b5(c->fore_color);
 
 		lcd_draw_pixel(x, y, cc);
+
+		c->pixels++;
 	#else
-		if (x >= 0 && y >= 0 && x < c->width && y < c->height)
+		if (x >= 0 && y >= c->clip_top && x < c->width && y < c->clip_bottom)
 		{
 			c->back_buffer[x + y * c->width] = c->fore_color;
+			c->pixels++;
 		}
 	#endif
 }
@@ -218,26 +345,274 @@ void rt_canvas_fill_circle(RT_Canvas* c, int16_t cx, int16_t cy, int16_t r)
 	}
 }
 
+static constexpr uint8_t BAYER_4X4[4][4] =
+{
+	{  0,  8,  2, 10 },
+	{ 12,  4, 14,  6 },
+	{  3, 11,  1,  9 },
+	{ 15,  7, 13,  5 },
+};
+
+// fills [x0, x1) on row `y`, taking the shade of the canvas into account
+static void fill_span(RT_Canvas* c, int16_t x0, int16_t x1, int16_t y)
+{
+	if (c->shade >= 16)
+	{
+		rt_canvas_fill_rect(c, x0, y, x1 - x0, 1);
+		return;
+	}
+
+	const uint8_t* threshold = BAYER_4X4[y & 3];
+
+	c->pixels += x1 - x0;
+
+	for (int16_t x = x0; x < x1; x++)
+	{
+		const uint8_t color = threshold[x & 3] < c->shade ? c->fore_color : c->back_color;
+
+		#if defined PICO_RP2040
+			lcd_draw_pixel(x, y, r3g3b2_to_r5g6b5(color));
+		#else
+			c->back_buffer[x + y * c->width] = color;
+		#endif
+	}
+}
+
+static int64_t floor_div(int64_t a, int64_t b)
+{
+	return a / b - ((a % b != 0) && ((a < 0) != (b < 0)));
+}
+
+static int64_t ceil_div(int64_t a, int64_t b)
+{
+	return -floor_div(-a, b);
+}
+
+// scanline rasterizer based on edge functions.
+//
+// positions are in fixed point with one fractional bit, so pixel centers 
+// land on odd coordinates. for each row, every edge function is linear in x, 
+// so each edge clamps the span from one side, and the constant part is 
+// stepped incrementally from row to row. pixels lying exactly on an edge are 
+// only filled if the edge is a top or left one, so shapes sharing an edge 
+// never overdraw or leave gaps between them.
+static void fill_convex(RT_Canvas* c, const int16_t* xs, const int16_t* ys, uint16_t n)
+{
+	if (n < 3 || n > RT_MAX_POLYGON_POINTS)
+	{
+		return;
+	}
+
+	int64_t area = 0;
+
+	int16_t min_y = ys[0];
+	int16_t max_y = ys[0];
+
+	for (uint16_t i = 0; i < n; i++)
+	{
+		const uint16_t j = (i + 1) % n;
+
+		area += (int64_t)xs[i] * ys[j] - (int64_t)xs[j] * ys[i];
+
+		min_y = MIN(min_y, ys[i]);
+		max_y = MAX(max_y, ys[i]);
+	}
+
+	if (area == 0)
+	{
+		return;
+	}
+
+	const int16_t y0 = MAX(min_y, c->clip_top);
+	const int16_t y1 = MIN(max_y, (int16_t)(c->clip_bottom - 1));
+
+	if (y0 > y1)
+	{
+		return;
+	}
+
+	// per edge: E(px, py) = dx * (py - ay) - dy * (px - ax), which is >= 0 inside.
+	// at row py this becomes a * px + k, with k stepping by 2 * dx for each row.
+	int64_t a[RT_MAX_POLYGON_POINTS];
+	int64_t k[RT_MAX_POLYGON_POINTS];
+	int64_t k_step[RT_MAX_POLYGON_POINTS];
+	int64_t bias[RT_MAX_POLYGON_POINTS];
+
+	for (uint16_t i = 0; i < n; i++)
+	{
+		// walk the edges the other way around for the opposite winding
+		const uint16_t from = area > 0 ? i : (n - i) % n;
+		const uint16_t to = area > 0 ? (i + 1) % n : (2 * n - i - 1) % n;
+
+		const int64_t ax = xs[from] * 2, ay = ys[from] * 2;
+		const int64_t dx = (xs[to] - xs[from]) * 2;
+		const int64_t dy = (ys[to] - ys[from]) * 2;
+
+		const int64_t py = y0 * 2 + 1;
+
+		a[i] = -dy;
+		k[i] = dx * (py - ay) + dy * ax;
+		k_step[i] = 2 * dx;
+
+		const bool top_left = dy < 0 || (dy == 0 && dx > 0);
+
+		bias[i] = top_left ? 0 : 1;
+	}
+
+	for (int16_t y = y0; y <= y1; y++)
+	{
+		int64_t x0 = 0;
+		int64_t x1 = c->width - 1;
+
+		for (uint16_t i = 0; i < n; i++)
+		{
+			// a * (2x + 1) + k >= bias  <=>  2a * x >= bias - k - a
+			const int64_t rhs = bias[i] - k[i] - a[i];
+
+			if (a[i] > 0)
+			{
+				x0 = MAX(x0, ceil_div(rhs, 2 * a[i]));
+			}
+			else if (a[i] < 0)
+			{
+				x1 = MIN(x1, floor_div(-rhs, -2 * a[i]));
+			}
+			else if (rhs > 0)
+			{
+				x1 = -1;
+			}
+
+			k[i] += k_step[i];
+		}
+
+		if (x0 <= x1)
+		{
+			fill_span(c, (int16_t)x0, (int16_t)(x1 + 1), y);
+		}
+	}
+}
+
+void rt_canvas_fill_triangle(RT_Canvas* c, int16_t x0, int16_t y0, int16_t x1, int16_t y1, int16_t x2, int16_t y2)
+{
+	const int16_t xs[3] = { x0, x1, x2 };
+	const int16_t ys[3] = { y0, y1, y2 };
+
+	fill_convex(c, xs, ys, 3);
+}
+
+void rt_canvas_fill_polygon(RT_Canvas* c, const int16_t* xs, const int16_t* ys, uint16_t n)
+{
+	fill_convex(c, xs, ys, n);
+}
+
+void rt_canvas_blit(RT_Canvas* c, const RT_Bitmap* b, int16_t sx, int16_t sy, int16_t w, int16_t h, int16_t x, int16_t y, uint8_t flags)
+{
+	// clip the source region against the bitmap
+	if (sx < 0) 
+	{
+		w += sx, x -= sx, sx = 0;
+	}
+
+	if (sy < 0)
+	{
+		h += sy, y -= sy, sy = 0;
+	}
+
+	w = MIN(w, (int16_t)(b->width - sx));
+	h = MIN(h, (int16_t)(b->height - sy));
+
+	// ...and the destination against the canvas
+	const int16_t x0 = MAX(x, (int16_t)0);
+	const int16_t y0 = MAX(y, c->clip_top);
+	const int16_t x1 = MIN((int16_t)(x + w), (int16_t)c->width);
+	const int16_t y1 = MIN((int16_t)(y + h), c->clip_bottom);
+
+	if (x0 >= x1 || y0 >= y1)
+	{
+		return;
+	}
+
+	const bool flip_x = flags & RT_BLIT_FLIP_X;
+	const bool flip_y = flags & RT_BLIT_FLIP_Y;
+
+	c->pixels += (x1 - x0) * (y1 - y0);
+
+	for (int16_t dy = y0; dy < y1; dy++)
+	{
+		const int16_t row = flip_y ? (h - 1) - (dy - y) : dy - y;
+
+		const uint8_t* src = b->pixels + (sy + row) * b->width + sx;
+
+		#if !defined PICO_RP2040
+			uint8_t* dst = c->back_buffer + dy * c->width;
+
+			// opaque, unflipped rows are a straight copy
+			if (!flip_x && !b->palette && b->key < 0)
+			{
+				__builtin_memcpy(dst + x0, src + (x0 - x), x1 - x0);
+				continue;
+			}
+		#endif
+
+		for (int16_t dx = x0; dx < x1; dx++)
+		{
+			const uint8_t p = src[flip_x ? (w - 1) - (dx - x) : dx - x];
+
+			if (p == b->key)
+			{
+				continue;
+			}
+
+			const uint8_t color = b->palette ? b->palette[p] : p;
+
+			#if defined PICO_RP2040
+				lcd_draw_pixel(dx, dy, r3g3b2_to_r5g6b5(color));
+			#else
+				dst[dx] = color;
+			#endif
+		}
+	}
+}
+
+static void draw_glyph(RT_Canvas* c, const RT_Glyph* g, int16_t x, int16_t y, int16_t s)
+{
+	for (uint8_t i = 0; i < g->rect_count; i++)
+	{
+		const RT_GlyphRect r = g->rects[i];
+
+		rt_canvas_fill_rect(c, x + r.x * s, y + r.y * s, r.w * s, r.h * s);
+	}
+}
+
 void rt_canvas_text(RT_Canvas* c, int16_t x, int16_t y, int16_t s, String text)
 {
-	uint16_t px = 0;
-	uint16_t py = 0;
+	if (s <= 0)
+	{
+		return;
+	}
+
+	const int16_t size = 8 * s;
+
+	int16_t px = 0;
+	int16_t py = 0;
 
 	for (size_t i = 0; i < text.length; i++) 
 	{
-		if (text.buffer[i] == ' ')
+		const uint8_t ch = (uint8_t)text.buffer[i];
+
+		if (ch == ' ')
 		{
 			px++;
 			continue;
 		}
 
-		if (text.buffer[i] == '\t')
+		if (ch == '\t')
 		{
 			px += 3;
 			continue;
 		}
 
-		if (text.buffer[i] == '\n')
+		if (ch == '\n')
 		{
 			px = 0;
 			py++;
@@ -245,21 +620,62 @@ void rt_canvas_text(RT_Canvas* c, int16_t x, int16_t y, int16_t s, String text)
 			continue;
 		}
 
-		for (uint8_t tx = 0; tx < 8; tx++)
+		const int16_t gx = x + px * size;
+		const int16_t gy = y + py * size;
+
+		px++;
+
+		// skip glyphs that fall completely outside of the canvas
+		if (gx >= c->width || gy >= c->clip_bottom || gx + size <= 0 || gy + size <= c->clip_top)
+		{
+			continue;
+		}
+
+		if (ch < COUNT_OF(glyph_atlas))
 		{
-			for (uint8_t ty = 0; ty < 8; ty++)
+			draw_glyph(c, &glyph_atlas[ch], gx, gy, s);
+		}
+	}
+}
+
+RT_TextSize rt_canvas_measure_text(int16_t s, String text)
+{
+	RT_TextSize size = {};
+
+	if (text.length == 0)
+	{
+		return size;
+	}
+
+	// in 32 bits, long strings or large scales would wrap around in 16
+	int32_t px = 0;
+	int32_t py = 0;
+	int32_t width = 0;
+
+	for (size_t i = 0; i < text.length; i++)
+	{
+		switch (text.buffer[i])
+		{
+			case '\t': px += 3; break;
+
+			case '\n':
 			{
-				if (!((font8x8_basic[text.buffer[i]][ty] >> tx) & 1))
-				{
-					continue;
-				}
+				px = 0;
+				py++;
+			} break;
 
-				rt_canvas_fill_rect(c, x + (px * 8 * s) + (tx * s), y + (py * 8 * s) + (ty * s), s, s);
-			}
+			default: px++; break;
 		}
 
-		px++;
+		width = MAX(width, px);
 	}
+
+	const int64_t scale = 8 * (int64_t)s;
+
+	size.width = (int16_t)CLAMP(width * scale, 0, INT16_MAX);
+	size.height = (int16_t)CLAMP((py + 1) * scale, 0, INT16_MAX);
+
+	return size;
 }
 
 uint8_t rt_canvas_pack_color(uint8_t r, uint8_t g, uint8_t b)
@@ -6,6 +6,32 @@
 
 #include <runtime/config.h>
 
+typedef struct RT_TextSize RT_TextSize;
+struct RT_TextSize
+{
+	int16_t width;
+	int16_t height;
+};
+
+// a block of R3G3B2 pixels, or of palette indices when `palette` is set.
+typedef struct RT_Bitmap RT_Bitmap;
+struct RT_Bitmap
+{
+	uint8_t* pixels;
+	uint8_t* palette; // 256 entries
+
+	uint16_t width;
+	uint16_t height;
+
+	int16_t key; // transparent color (or index), -1 for none
+};
+
+typedef enum : uint8_t
+{
+	RT_BLIT_FLIP_X = 1 << 0,
+	RT_BLIT_FLIP_Y = 1 << 1,
+} RT_BlitFlags;
+
 typedef struct RT_Canvas RT_Canvas;
 struct RT_Canvas
 {
@@ -19,6 +45,18 @@ struct RT_Canvas
 	uint8_t fore_color;
 
 	uint16_t line_width;
+
+	// ordered dither level used by triangle and polygon fills, from 0 (all back color) to 16 (solid fore color)
+	uint8_t shade;
+
+	// rows outside [clip_top, clip_bottom) are left untouched, so a frame can be 
+	// rasterized in independent horizontal bands.
+	int16_t clip_top;
+	int16_t clip_bottom;
+
+	// pixels filled so far, for frame statistics. counted a span at a time, so
+	// the transparent pixels of a blit count too.
+	uint32_t pixels;
 };
 
 RT_Canvas rt_canvas_make(Arena* arena, uint16_t width, uint16_t height);
@@ -39,8 +77,19 @@ void rt_canvas_circle(RT_Canvas* c, int16_t cx, int16_t cy, int16_t r);
 
 void rt_canvas_fill_circle(RT_Canvas* c, int16_t cx, int16_t cy, int16_t r);
 
+void rt_canvas_fill_triangle(RT_Canvas* c, int16_t x0, int16_t y0, int16_t x1, int16_t y1, int16_t x2, int16_t y2);
+
+// `xs` and `ys` describe a convex polygon of up to RT_MAX_POLYGON_POINTS points, in either winding order
+void rt_canvas_fill_polygon(RT_Canvas* c, const int16_t* xs, const int16_t* ys, uint16_t n);
+
+// copies the region (sx, sy, w, h) of `b` to (x, y), clipped to both the bitmap and the canvas
+void rt_canvas_blit(RT_Canvas* c, const RT_Bitmap* b, int16_t sx, int16_t sy, int16_t w, int16_t h, int16_t x, int16_t y, uint8_t flags);
+
 void rt_canvas_text(RT_Canvas* c, int16_t x, int16_t y, int16_t s, String text);
 
+// size in pixels of the box `rt_canvas_text` would cover, without drawing anything
+RT_TextSize rt_canvas_measure_text(int16_t s, String text);
+
 // we are doing one byte per pixel, 3 bits for R, 3 bits for G, 2 for B.
 // R3G3B2
 uint8_t rt_canvas_pack_color(uint8_t r, uint8_t g, uint8_t b);
\ No newline at end of file
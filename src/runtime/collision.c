@@ -0,0 +1,240 @@
+#include <runtime/collision.h>
+
+#if defined PQ_FIXED_POINT
+	typedef SIMD_I32x4 NumberX4;
+#else
+	typedef SIMD_F32x4 NumberX4;
+#endif
+
+static inline NumberX4 load_x4(const PQ_Number* p)
+{
+	NumberX4 v;
+	__builtin_memcpy(&v, p, sizeof(v));
+
+	return v;
+}
+
+static inline NumberX4 splat_x4(PQ_Number n)
+{
+	return (NumberX4){} + n;
+}
+
+static inline uint32_t lane_bits(SIMD_I32x4 m)
+{
+	return (m[0] & 1) | (m[1] & 2) | (m[2] & 4) | (m[3] & 8);
+}
+
+// the lanes of a vector starting `left` elements before the end of a range
+static inline uint32_t lane_mask(uint32_t left)
+{
+	return left < SIMD_LANES ? (1u << left) - 1 : 0xf;
+}
+
+// which of the bodies j..j+3 overlap the query, one bit per lane
+static uint32_t overlaps_x4(const RT_Bodies* b, uint32_t j, PQ_Number x, PQ_Number y, PQ_Number w, PQ_Number h)
+{
+	const NumberX4 bx = load_x4(b->x + j);
+	const NumberX4 by = load_x4(b->y + j);
+	const NumberX4 bw = load_x4(b->w + j);
+
+	if (!b->circles)
+	{
+		const NumberX4 bh = load_x4(b->h + j);
+
+		return lane_bits(
+			(bx < splat_x4(pq_number_add(x, w))) & (splat_x4(x) < bx + bw) &
+			(by < splat_x4(pq_number_add(y, h))) & (splat_x4(y) < by + bh));
+	}
+
+	#if defined PQ_FIXED_POINT
+		// the squares don't fit in 32 bits
+		uint32_t bits = 0;
+
+		for (uint32_t l = 0; l < SIMD_LANES; l++)
+		{
+			const int64_t dx = (int64_t)bx[l] - x;
+			const int64_t dy = (int64_t)by[l] - y;
+			const int64_t r = (int64_t)bw[l] + w;
+
+			bits |= (uint32_t)(dx * dx + dy * dy < r * r) << l;
+		}
+
+		return bits;
+	#else
+		const NumberX4 dx = bx - splat_x4(x);
+		const NumberX4 dy = by - splat_x4(y);
+		const NumberX4 r = bw + splat_x4(w);
+
+		return lane_bits(dx * dx + dy * dy < r * r);
+	#endif
+}
+
+// the top left corner of the bounds of a body, and their larger side
+static PQ_Number corner_x(const RT_Bodies* b, uint16_t i) { return b->circles ? pq_number_sub(b->x[i], b->w[i]) : b->x[i]; }
+static PQ_Number corner_y(const RT_Bodies* b, uint16_t i) { return b->circles ? pq_number_sub(b->y[i], b->w[i]) : b->y[i]; }
+static PQ_Number extent(const RT_Bodies* b, uint16_t i) { return b->circles ? pq_number_add(b->w[i], b->w[i]) : MAX(b->w[i], b->h[i]); }
+
+static uint16_t cell_of(PQ_Number v, PQ_Number min, PQ_Number cell, uint16_t size)
+{
+	const int32_t c = pq_number_to_int(pq_number_div(pq_number_sub(v, min), cell));
+
+	return (uint16_t)CLAMP(c, 0, size - 1);
+}
+
+// tests body p of the sorted bodies against the range [from, to) of them
+static uint16_t collect_pairs(const RT_Bodies* s, const uint16_t* order, uint16_t p, uint16_t from, uint16_t to, uint16_t* pairs, uint16_t count, uint16_t max_pairs)
+{
+	for (uint32_t j = from; j < to; j += SIMD_LANES)
+	{
+		uint32_t bits = overlaps_x4(s, j, s->x[p], s->y[p], s->w[p], s->h[p]) & lane_mask(to - j);
+
+		while (bits)
+		{
+			const uint16_t a = order[p];
+			const uint16_t b = order[j + __builtin_ctz(bits)];
+
+			pairs[2 * count + 0] = MIN(a, b);
+			pairs[2 * count + 1] = MAX(a, b);
+
+			if (++count == max_pairs)
+			{
+				return count;
+			}
+
+			bits &= bits - 1;
+		}
+	}
+
+	return count;
+}
+
+//
+// interface
+//
+
+void rt_bodies_init(RT_Bodies* b, Arena* arena, uint16_t count, bool circles)
+{
+	// a vector may start at any body, so the last one reads up to 3 past the end
+	const uint32_t capacity = count + SIMD_LANES;
+
+	b->x = arena_push_array(arena, PQ_Number, capacity);
+	b->y = arena_push_array(arena, PQ_Number, capacity);
+	b->w = arena_push_array(arena, PQ_Number, capacity);
+	b->h = circles ? b->w : arena_push_array(arena, PQ_Number, capacity);
+
+	b->count = count;
+	b->circles = circles;
+}
+
+int32_t rt_bodies_first_hit(const RT_Bodies* b, PQ_Number x, PQ_Number y, PQ_Number w, PQ_Number h)
+{
+	for (uint32_t j = 0; j < b->count; j += SIMD_LANES)
+	{
+		const uint32_t bits = overlaps_x4(b, j, x, y, w, h) & lane_mask(b->count - j);
+
+		if (bits)
+		{
+			return (int32_t)(j + __builtin_ctz(bits));
+		}
+	}
+
+	return -1;
+}
+
+// bodies are binned by the top left corner of their bounds. cells are at least as
+// big as the largest body, so overlapping bodies are never more than a cell apart.
+// each pair is found from the body that comes first in the grid: it checks the rest
+// of its own row of cells, and the three cells below.
+uint16_t rt_bodies_pairs(const RT_Bodies* b, Arena* arena, uint16_t* pairs, uint16_t max_pairs)
+{
+	if (b->count < 2 || max_pairs == 0)
+	{
+		return 0;
+	}
+
+	Scratch scratch = scratch_make(arena);
+
+	PQ_Number min_x = corner_x(b, 0);
+	PQ_Number min_y = corner_y(b, 0);
+	PQ_Number max_x = min_x;
+	PQ_Number max_y = min_y;
+	PQ_Number cell = pq_number_from_int(1);
+
+	for (uint16_t i = 0; i < b->count; i++)
+	{
+		min_x = MIN(min_x, corner_x(b, i));
+		min_y = MIN(min_y, corner_y(b, i));
+		max_x = MAX(max_x, corner_x(b, i));
+		max_y = MAX(max_y, corner_y(b, i));
+		cell = MAX(cell, extent(b, i));
+	}
+
+	// bodies spread out over a large area get bigger cells, rather than more of them
+	const PQ_Number grid_cells = pq_number_from_int(RT_COLLISION_GRID_SIZE - 1);
+
+	cell = MAX(cell, pq_number_div(pq_number_sub(max_x, min_x), grid_cells));
+	cell = MAX(cell, pq_number_div(pq_number_sub(max_y, min_y), grid_cells));
+
+	const uint16_t columns = cell_of(max_x, min_x, cell, RT_COLLISION_GRID_SIZE) + 1;
+	const uint16_t rows = cell_of(max_y, min_y, cell, RT_COLLISION_GRID_SIZE) + 1;
+
+	// counting sort by cell, into a copy of the bodies so cells can be scanned a vector at a time
+	uint16_t* cells = arena_push_array_uninit(arena, uint16_t, b->count);
+	uint16_t* starts = arena_push_array(arena, uint16_t, columns * rows + 1);
+	uint16_t* cursors = arena_push_array_uninit(arena, uint16_t, columns * rows);
+
+	for (uint16_t i = 0; i < b->count; i++)
+	{
+		cells[i] = cell_of(corner_y(b, i), min_y, cell, rows) * columns + cell_of(corner_x(b, i), min_x, cell, columns);
+
+		starts[cells[i] + 1]++;
+	}
+
+	for (uint16_t c = 1; c <= columns * rows; c++)
+	{
+		starts[c] += starts[c - 1];
+	}
+
+	__builtin_memcpy(cursors, starts, columns * rows * sizeof(uint16_t));
+
+	RT_Bodies sorted;
+	rt_bodies_init(&sorted, arena, b->count, b->circles);
+
+	uint16_t* order = arena_push_array_uninit(arena, uint16_t, b->count);
+
+	for (uint16_t i = 0; i < b->count; i++)
+	{
+		const uint16_t p = cursors[cells[i]]++;
+
+		order[p] = i;
+
+		sorted.x[p] = b->x[i];
+		sorted.y[p] = b->y[i];
+		sorted.w[p] = b->w[i];
+		sorted.h[p] = b->h[i];
+	}
+
+	uint16_t count = 0;
+
+	for (uint16_t p = 0; p < b->count && count < max_pairs; p++)
+	{
+		const uint16_t cx = cells[order[p]] % columns;
+		const uint16_t cy = cells[order[p]] / columns;
+
+		const uint16_t left = cx > 0 ? cx - 1 : 0;
+		const uint16_t right = MIN((uint16_t)(cx + 1), (uint16_t)(columns - 1));
+
+		count = collect_pairs(&sorted, order, p, p + 1, starts[cy * columns + right + 1], pairs, count, max_pairs);
+
+		if (cy + 1 < rows && count < max_pairs)
+		{
+			const uint16_t below = (cy + 1) * columns;
+
+			count = collect_pairs(&sorted, order, p, starts[below + left], starts[below + right + 1], pairs, count, max_pairs);
+		}
+	}
+
+	scratch_release(scratch);
+
+	return count;
+}
@@ -0,0 +1,35 @@
+#pragma once
+
+#include <base/common.h>
+#include <base/arena.h>
+#include <base/simd.h>
+
+#include <pq/types.h>
+
+#include <runtime/config.h>
+
+// parallel arrays of boxes (x, y, w, h) or circles (x, y, r, with r kept in w).
+// they're padded to whole simd vectors, the padding is never reported as a hit.
+typedef struct RT_Bodies RT_Bodies;
+struct RT_Bodies
+{
+	PQ_Number* x;
+	PQ_Number* y;
+	PQ_Number* w;
+	PQ_Number* h;
+
+	uint16_t count;
+	bool circles;
+};
+
+// room for `count` bodies, for the caller to fill in
+void rt_bodies_init(RT_Bodies* b, Arena* arena, uint16_t count, bool circles);
+
+// index of the first body overlapping the query (a box, or a circle if the bodies are), or -1.
+// touching edges don't count as overlapping.
+int32_t rt_bodies_first_hit(const RT_Bodies* b, PQ_Number x, PQ_Number y, PQ_Number w, PQ_Number h);
+
+// writes up to `max_pairs` overlapping pairs (i, j with i < j) into `pairs`, in no
+// particular order, and returns how many it wrote. the broadphase is a uniform
+// grid built in `arena`, which is rewound before returning.
+uint16_t rt_bodies_pairs(const RT_Bodies* b, Arena* arena, uint16_t* pairs, uint16_t max_pairs);
@@ -0,0 +1,276 @@
+#include <runtime/commands.h>
+
+static int16_t band_height(const RT_Canvas* c)
+{
+	return (c->height + RT_RENDER_BANDS - 1) / RT_RENDER_BANDS;
+}
+
+static uint8_t bands_of(const RT_Canvas* c, int32_t top, int32_t bottom)
+{
+	top = MAX(top, 0);
+	bottom = MIN(bottom, (int32_t)c->height - 1);
+
+	if (top > bottom)
+	{
+		return 0;
+	}
+
+	const uint8_t first = top / band_height(c);
+	const uint8_t last = bottom / band_height(c);
+
+	return (uint8_t)(((1u << (last + 1)) - 1) & ~((1u << first) - 1));
+}
+
+// rows a command may cover, inclusive
+static uint8_t command_bands(const RT_Canvas* c, const RT_Command* cmd)
+{
+	const int16_t* a = cmd->args;
+	const int16_t lw = cmd->line_width;
+
+	switch (cmd->type)
+	{
+		case RT_COMMAND_LINE:        return bands_of(c, MIN(a[1], a[3]), MAX(a[1], a[3]));
+		case RT_COMMAND_RECT:        return bands_of(c, a[1] - lw, a[1] + a[3] + lw);
+		case RT_COMMAND_FILL_RECT:   return bands_of(c, a[1], a[1] + a[3] - 1);
+		case RT_COMMAND_PUT:         return bands_of(c, a[1], a[1]);
+		case RT_COMMAND_CIRCLE:      return bands_of(c, a[1] - a[2] - lw, a[1] + a[2] + lw);
+		case RT_COMMAND_FILL_CIRCLE: return bands_of(c, a[1] - a[2], a[1] + a[2]);
+		case RT_COMMAND_BLIT:        return bands_of(c, a[5], a[5] + a[3] - 1);
+
+		case RT_COMMAND_TEXT:
+		{
+			RT_TextSize size = rt_canvas_measure_text(a[2], (String){ cmd->data, cmd->data_size });
+
+			return bands_of(c, a[1], a[1] + size.height - 1);
+		}
+
+		case RT_COMMAND_FILL_TRIANGLE: 
+		{
+			return bands_of(c, MIN(MIN(a[1], a[3]), a[5]), MAX(MAX(a[1], a[3]), a[5]));
+		}
+
+		case RT_COMMAND_PIXELS:      return bands_of(c, a[1], a[1] + a[3] - 1);
+
+		case RT_COMMAND_FILL_POLYGON:
+		case RT_COMMAND_POINTS:
+		case RT_COMMAND_LINES:
+		case RT_COMMAND_FILL_RECTS:
+		case RT_COMMAND_PARTICLES:
+		{
+			const int16_t* ys = (const int16_t*)cmd->data + cmd->data_size;
+			const int16_t* hs = ys + 2 * cmd->data_size;
+
+			int32_t top = ys[0];
+			int32_t bottom = ys[0];
+
+			for (uint16_t i = 0; i < cmd->data_size; i++)
+			{
+				top = MIN(top, (int32_t)ys[i]);
+				bottom = MAX(bottom, cmd->type == RT_COMMAND_FILL_RECTS ? ys[i] + hs[i] - 1 : ys[i]);
+			}
+
+			if (cmd->type == RT_COMMAND_LINES)
+			{
+				top -= lw;
+				bottom += lw;
+			}
+
+			return bands_of(c, top, bottom);
+		}
+
+		default: return (uint8_t)((1u << RT_RENDER_BANDS) - 1);
+	}
+}
+
+static uint16_t command_payload_size(const RT_Command* cmd)
+{
+	switch (cmd->type)
+	{
+		case RT_COMMAND_TEXT:         return cmd->data_size;
+		case RT_COMMAND_FILL_POLYGON: return cmd->data_size * 2 * sizeof(int16_t);
+		case RT_COMMAND_POINTS:       return cmd->data_size * 2 * sizeof(int16_t);
+		case RT_COMMAND_LINES:        return cmd->data_size * 2 * sizeof(int16_t);
+		case RT_COMMAND_FILL_RECTS:   return cmd->data_size * 4 * sizeof(int16_t);
+		case RT_COMMAND_PIXELS:       return cmd->data_size;
+		case RT_COMMAND_PARTICLES:    return cmd->data_size * (2 * sizeof(int16_t) + 1);
+
+		default: return 0;
+	}
+}
+
+void rt_command_execute(const RT_Command* cmd, RT_Canvas* c)
+{
+	const int16_t* a = cmd->args;
+
+	c->fore_color = cmd->fore_color;
+	c->back_color = cmd->back_color;
+	c->shade = cmd->shade;
+	c->line_width = cmd->line_width;
+
+	switch (cmd->type)
+	{
+		case RT_COMMAND_CLEAR:         rt_canvas_clear(c); break;
+		case RT_COMMAND_LINE:          rt_canvas_line(c, a[0], a[1], a[2], a[3]); break;
+		case RT_COMMAND_RECT:          rt_canvas_rect(c, a[0], a[1], a[2], a[3]); break;
+		case RT_COMMAND_FILL_RECT:     rt_canvas_fill_rect(c, a[0], a[1], a[2], a[3]); break;
+		case RT_COMMAND_PUT:           rt_canvas_put(c, a[0], a[1]); break;
+		case RT_COMMAND_CIRCLE:        rt_canvas_circle(c, a[0], a[1], a[2]); break;
+		case RT_COMMAND_FILL_CIRCLE:   rt_canvas_fill_circle(c, a[0], a[1], a[2]); break;
+		case RT_COMMAND_TEXT:          rt_canvas_text(c, a[0], a[1], a[2], (String){ cmd->data, cmd->data_size }); break;
+		case RT_COMMAND_FILL_TRIANGLE: rt_canvas_fill_triangle(c, a[0], a[1], a[2], a[3], a[4], a[5]); break;
+		case RT_COMMAND_TILEMAP:       rt_tilemap_draw(cmd->data, c, a[0], a[1]); break;
+
+		case RT_COMMAND_BLIT:
+		{
+			RT_Bitmap b = *(const RT_Bitmap*)cmd->data;
+
+			b.key = cmd->key;
+
+			rt_canvas_blit(c, &b, a[0], a[1], a[2], a[3], a[4], a[5], cmd->flags);
+		} break;
+
+		case RT_COMMAND_FILL_POLYGON:
+		{
+			const int16_t* xs = cmd->data;
+
+			rt_canvas_fill_polygon(c, xs, xs + cmd->data_size, cmd->data_size);
+		} break;
+
+		case RT_COMMAND_POINTS:
+		{
+			const int16_t* xs = cmd->data;
+			const int16_t* ys = xs + cmd->data_size;
+
+			for (uint16_t i = 0; i < cmd->data_size; i++)
+			{
+				rt_canvas_put(c, xs[i], ys[i]);
+			}
+		} break;
+
+		case RT_COMMAND_LINES:
+		{
+			const int16_t* xs = cmd->data;
+			const int16_t* ys = xs + cmd->data_size;
+
+			for (uint16_t i = 1; i < cmd->data_size; i++)
+			{
+				rt_canvas_line(c, xs[i - 1], ys[i - 1], xs[i], ys[i]);
+			}
+		} break;
+
+		case RT_COMMAND_FILL_RECTS:
+		{
+			const int16_t* xs = cmd->data;
+			const int16_t* ys = xs + cmd->data_size;
+			const int16_t* ws = ys + cmd->data_size;
+			const int16_t* hs = ws + cmd->data_size;
+
+			for (uint16_t i = 0; i < cmd->data_size; i++)
+			{
+				rt_canvas_fill_rect(c, xs[i], ys[i], ws[i], hs[i]);
+			}
+		} break;
+
+		case RT_COMMAND_PIXELS:
+		{
+			const RT_Bitmap b = { .pixels = cmd->data, .width = a[2], .height = a[3], .key = -1 };
+
+			rt_canvas_blit(c, &b, 0, 0, a[2], a[3], a[0], a[1], 0);
+		} break;
+
+		case RT_COMMAND_PARTICLES:
+		{
+			const int16_t* xs = cmd->data;
+			const int16_t* ys = xs + cmd->data_size;
+			const uint8_t* colors = (const uint8_t*)(ys + cmd->data_size);
+
+			for (uint16_t i = 0; i < cmd->data_size; i++)
+			{
+				c->fore_color = colors[i];
+
+				rt_canvas_put(c, xs[i], ys[i]);
+			}
+
+			// when drawn right away, the canvas is the one the program keeps drawing with
+			c->fore_color = cmd->fore_color;
+		} break;
+	}
+}
+
+void rt_command_buffer_init(RT_CommandBuffer* cb, Arena* arena)
+{
+	ArenaTag tag = arena_set_tag(arena, ARENA_TAG_COMMANDS);
+
+	cb->commands = arena_push_array_uninit(arena, RT_Command, RT_MAX_DRAW_COMMANDS);
+	cb->payload = (uint8_t*)arena_push_array_uninit(arena, int16_t, RT_MAX_DRAW_PAYLOAD / sizeof(int16_t));
+
+	arena_set_tag(arena, tag);
+
+	rt_command_buffer_reset(cb);
+}
+
+void rt_command_buffer_reset(RT_CommandBuffer* cb)
+{
+	cb->command_count = 0;
+	cb->payload_size = 0;
+}
+
+bool rt_command_buffer_push(RT_CommandBuffer* cb, const RT_Canvas* c, RT_Command cmd)
+{
+	if (cb->command_count >= RT_MAX_DRAW_COMMANDS)
+	{
+		return false;
+	}
+
+	const uint16_t size = command_payload_size(&cmd);
+
+	if (size > 0)
+	{
+		const uint16_t offset = __builtin_align_up(cb->payload_size, alignof(int16_t));
+
+		if (offset + size > RT_MAX_DRAW_PAYLOAD)
+		{
+			return false;
+		}
+
+		__builtin_memcpy(cb->payload + offset, cmd.data, size);
+
+		cmd.data = cb->payload + offset;
+		cb->payload_size = offset + size;
+	}
+
+	cmd.bands = command_bands(c, &cmd);
+
+	// nothing would be drawn
+	if (cmd.bands == 0)
+	{
+		return true;
+	}
+
+	cb->commands[cb->command_count++] = cmd;
+
+	return true;
+}
+
+uint32_t rt_command_buffer_execute(const RT_CommandBuffer* cb, const RT_Canvas* c, uint8_t band)
+{
+	// every band works on its own copy of the canvas, since the commands change its state
+	RT_Canvas bc = *c;
+
+	bc.pixels = 0;
+
+	bc.clip_top = MIN(band * band_height(c), (int32_t)c->height);
+	bc.clip_bottom = MIN((band + 1) * band_height(c), (int32_t)c->height);
+
+	for (uint16_t i = 0; i < cb->command_count; i++)
+	{
+		const RT_Command* cmd = &cb->commands[i];
+
+		if (cmd->bands & (1 << band))
+		{
+			rt_command_execute(cmd, &bc);
+		}
+	}
+
+	return bc.pixels;
+}
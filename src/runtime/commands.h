@@ -0,0 +1,83 @@
+#pragma once
+
+#include <base/common.h>
+#include <base/arena.h>
+
+#include <runtime/canvas.h>
+#include <runtime/tilemap.h>
+#include <runtime/config.h>
+
+typedef enum : uint8_t
+{
+	RT_COMMAND_CLEAR,
+	RT_COMMAND_LINE,
+	RT_COMMAND_RECT,
+	RT_COMMAND_FILL_RECT,
+	RT_COMMAND_PUT,
+	RT_COMMAND_CIRCLE,
+	RT_COMMAND_FILL_CIRCLE,
+	RT_COMMAND_TEXT,
+	RT_COMMAND_FILL_TRIANGLE,
+	RT_COMMAND_FILL_POLYGON,
+	RT_COMMAND_BLIT,
+	RT_COMMAND_TILEMAP,
+	RT_COMMAND_POINTS,
+	RT_COMMAND_LINES,
+	RT_COMMAND_FILL_RECTS,
+	RT_COMMAND_PIXELS,
+	RT_COMMAND_PARTICLES,
+} RT_CommandType;
+
+// a single draw call, along with the canvas state it was issued with.
+typedef struct RT_Command RT_Command;
+struct RT_Command
+{
+	RT_CommandType type;
+
+	uint8_t fore_color;
+	uint8_t back_color;
+	uint8_t shade;
+	uint16_t line_width;
+
+	uint8_t flags;
+
+	// one bit per band of rows the command may touch
+	uint8_t bands;
+
+	int16_t args[6];
+
+	// blits: the key of the sprite at the time it was drawn
+	int16_t key;
+
+	// text (data_size bytes), polygon points (data_size xs followed by as many ys), sprite (read for everything but its key) or tilemap.
+	// batches lay out data_size xs, ys (then ws, hs for rects, or a color byte each for particles),
+	// pixels are data_size bytes.
+	void* data;
+	uint16_t data_size;
+};
+
+// draw calls recorded over a frame, to be rasterized later, a band per thread.
+// commands are binned into RT_RENDER_BANDS horizontal bands as they are 
+// recorded, so each pass over the canvas stays within a band of its rows.
+typedef struct RT_CommandBuffer RT_CommandBuffer;
+struct RT_CommandBuffer
+{
+	RT_Command* commands;
+	uint16_t command_count;
+
+	uint8_t* payload;
+	uint16_t payload_size;
+};
+
+void rt_command_execute(const RT_Command* cmd, RT_Canvas* c);
+
+void rt_command_buffer_init(RT_CommandBuffer* cb, Arena* arena);
+
+void rt_command_buffer_reset(RT_CommandBuffer* cb);
+
+// copies `cmd` and its text or points into the buffer. returns false if the buffer is full.
+bool rt_command_buffer_push(RT_CommandBuffer* cb, const RT_Canvas* c, RT_Command cmd);
+
+// rasterizes the commands touching `band` into the rows of `c` that belong to it.
+// returns how many pixels it filled, `c->pixels` is left alone.
+uint32_t rt_command_buffer_execute(const RT_CommandBuffer* cb, const RT_Canvas* c, uint8_t band);
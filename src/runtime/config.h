@@ -6,4 +6,36 @@ static constexpr uint32_t RT_MAX_VM_MEM = 128 * 1024;
 static constexpr uint32_t RT_MAX_COMPILER_MEM = 4 * 1024 * 1024;
 
 static constexpr uint16_t RT_CANVAS_WIDTH = 240;
-static constexpr uint16_t RT_CANVAS_HEIGHT = 320;
\ No newline at end of file
+static constexpr uint16_t RT_CANVAS_HEIGHT = 320;
+
+static constexpr uint16_t RT_MAX_POLYGON_POINTS = 32;
+
+// batch draw calls are split into commands of at most this many primitives (or pixels)
+static constexpr uint16_t RT_MAX_BATCH_SIZE = 128;
+static constexpr uint16_t RT_MAX_BATCH_PIXELS = 1024;
+
+static constexpr uint16_t RT_MAX_SPRITES = 64;
+static constexpr uint32_t RT_MAX_SPRITE_MEM = 16 * 1024;
+static constexpr uint16_t RT_SPRITE_MAX_DIM = 256;
+
+static constexpr uint16_t RT_MAX_TILEMAP_SIZE = 64;
+
+// collision queries copy their bodies into scratch memory, the pair queries bin
+// them into a grid of up to RT_COLLISION_GRID_SIZE x RT_COLLISION_GRID_SIZE cells
+static constexpr uint16_t RT_MAX_COLLISION_BODIES = 512;
+static constexpr uint16_t RT_MAX_COLLISION_PAIRS = 512;
+static constexpr uint16_t RT_COLLISION_GRID_SIZE = 32;
+
+static constexpr uint16_t RT_MAX_PARTICLES = 512;
+static constexpr uint8_t RT_MAX_PARTICLE_RAMPS = 8;
+static constexpr uint8_t RT_MAX_RAMP_COLORS = 8;
+
+// how often programs in frame mode get their update and draw called
+static constexpr uint16_t RT_FRAME_RATE = 60;
+
+static constexpr uint16_t RT_MAX_DRAW_COMMANDS = 512;
+static constexpr uint16_t RT_MAX_DRAW_PAYLOAD = 8 * 1024;
+static constexpr uint8_t RT_RENDER_BANDS = 4;
+
+// bump when DEFINE_RT_PROCEDURES changes in any way other than appending
+static constexpr uint16_t RT_REGISTRY_VERSION = 1;
\ No newline at end of file
@@ -0,0 +1,123 @@
+#include <runtime/particles.h>
+
+// fixed point saturates like everywhere else, so it stays scalar
+#if defined PQ_FIXED_POINT
+	static void add_number(PQ_Number* a, uint32_t n, PQ_Number v) { for (uint32_t i = 0; i < n; i++) a[i] = pq_number_add(a[i], v); }
+	static void accumulate_numbers(PQ_Number* a, const PQ_Number* b, uint32_t n) { for (uint32_t i = 0; i < n; i++) a[i] = pq_number_add(a[i], b[i]); }
+#else
+	static void add_number(PQ_Number* a, uint32_t n, PQ_Number v) { simd_add_f32(a, n, v); }
+	static void accumulate_numbers(PQ_Number* a, const PQ_Number* b, uint32_t n) { simd_accumulate_f32(a, b, n); }
+#endif
+
+// xorshift32
+static uint32_t next_random(RT_Particles* p)
+{
+	uint32_t x = p->seed;
+
+	x ^= x << 13;
+	x ^= x >> 17;
+	x ^= x << 5;
+
+	return p->seed = x;
+}
+
+// somewhere in [-spread, spread]
+static PQ_Number jitter(RT_Particles* p, PQ_Number spread)
+{
+	const int32_t r = (int32_t)(next_random(p) % 2001) - 1000;
+
+	return pq_number_mul(spread, pq_number_div(pq_number_from_int(r), pq_number_from_int(1000)));
+}
+
+static void remove_particle(RT_Particles* p, uint16_t i)
+{
+	const uint16_t last = --p->count;
+
+	p->x[i] = p->x[last];
+	p->y[i] = p->y[last];
+	p->vx[i] = p->vx[last];
+	p->vy[i] = p->vy[last];
+	p->age[i] = p->age[last];
+	p->life[i] = p->life[last];
+	p->ramp[i] = p->ramp[last];
+}
+
+//
+// interface
+//
+
+void rt_particles_init(RT_Particles* p, Arena* arena)
+{
+	*p = (RT_Particles){};
+
+	ArenaTag tag = arena_set_tag(arena, ARENA_TAG_PARTICLES);
+
+	p->x = arena_push_array_uninit(arena, PQ_Number, RT_MAX_PARTICLES);
+	p->y = arena_push_array_uninit(arena, PQ_Number, RT_MAX_PARTICLES);
+	p->vx = arena_push_array_uninit(arena, PQ_Number, RT_MAX_PARTICLES);
+	p->vy = arena_push_array_uninit(arena, PQ_Number, RT_MAX_PARTICLES);
+	p->age = arena_push_array_uninit(arena, int32_t, RT_MAX_PARTICLES);
+	p->life = arena_push_array_uninit(arena, int32_t, RT_MAX_PARTICLES);
+	p->ramp = arena_push_array_uninit(arena, uint8_t, RT_MAX_PARTICLES);
+
+	arena_set_tag(arena, tag);
+
+	// until they're set, every ramp is plain white
+	for (uint8_t i = 0; i < RT_MAX_PARTICLE_RAMPS; i++)
+	{
+		p->ramps[i][0] = 0xff;
+		p->ramp_sizes[i] = 1;
+	}
+
+	p->seed = 0x9e3779b9;
+}
+
+uint16_t rt_particles_emit(RT_Particles* p, uint16_t n, PQ_Number x, PQ_Number y, PQ_Number vx, PQ_Number vy, PQ_Number spread, int32_t life, uint8_t ramp)
+{
+	n = MIN(n, (uint16_t)(RT_MAX_PARTICLES - p->count));
+	life = MAX(life, 1);
+
+	for (uint16_t k = 0; k < n; k++)
+	{
+		const uint16_t i = p->count++;
+
+		p->x[i] = x;
+		p->y[i] = y;
+		p->vx[i] = pq_number_add(vx, jitter(p, spread));
+		p->vy[i] = pq_number_add(vy, jitter(p, spread));
+		p->age[i] = 0;
+		p->life[i] = life + (int32_t)(next_random(p) % (uint32_t)(life / 4 + 1));
+		p->ramp[i] = ramp % RT_MAX_PARTICLE_RAMPS;
+	}
+
+	return n;
+}
+
+void rt_particles_step(RT_Particles* p)
+{
+	add_number(p->vx, p->count, p->gravity_x);
+	add_number(p->vy, p->count, p->gravity_y);
+
+	accumulate_numbers(p->x, p->vx, p->count);
+	accumulate_numbers(p->y, p->vy, p->count);
+
+	simd_add_u32((uint32_t*)p->age, p->count, 1);
+
+	for (uint16_t i = 0; i < p->count;)
+	{
+		if (p->age[i] >= p->life[i])
+		{
+			remove_particle(p, i);
+			continue;
+		}
+
+		i++;
+	}
+}
+
+uint8_t rt_particles_color(const RT_Particles* p, uint16_t i)
+{
+	const uint8_t r = p->ramp[i];
+
+	return p->ramps[r][p->age[i] * p->ramp_sizes[r] / p->life[i]];
+}
@@ -0,0 +1,48 @@
+#pragma once
+
+#include <base/common.h>
+#include <base/arena.h>
+#include <base/simd.h>
+
+#include <pq/types.h>
+
+#include <runtime/config.h>
+
+// a fixed-capacity pool of particles, as parallel arrays so a step is a few
+// passes of simd adds. time is counted in steps: every step adds gravity to
+// the velocities and the velocities to the positions. particles take their
+// color from a ramp, going from its first to its last color over their life.
+typedef struct RT_Particles RT_Particles;
+struct RT_Particles
+{
+	PQ_Number* x;
+	PQ_Number* y;
+	PQ_Number* vx;
+	PQ_Number* vy;
+
+	int32_t* age;
+	int32_t* life;
+	uint8_t* ramp;
+
+	uint16_t count;
+
+	PQ_Number gravity_x;
+	PQ_Number gravity_y;
+
+	uint8_t ramps[RT_MAX_PARTICLE_RAMPS][RT_MAX_RAMP_COLORS];
+	uint8_t ramp_sizes[RT_MAX_PARTICLE_RAMPS];
+
+	uint32_t seed;
+};
+
+void rt_particles_init(RT_Particles* p, Arena* arena);
+
+// spawns up to n particles at (x, y), each with the velocity (vx, vy) plus up to
+// `spread` in any direction, living for `life` steps plus up to a quarter more.
+// returns how many fit in the pool.
+uint16_t rt_particles_emit(RT_Particles* p, uint16_t n, PQ_Number x, PQ_Number y, PQ_Number vx, PQ_Number vy, PQ_Number spread, int32_t life, uint8_t ramp);
+
+// moves every particle by one step, and removes the ones past their life
+void rt_particles_step(RT_Particles* p);
+
+uint8_t rt_particles_color(const RT_Particles* p, uint16_t i);
@@ -0,0 +1,43 @@
+#include <runtime/sprite.h>
+
+void rt_sprite_bank_init(RT_SpriteBank* sb, Arena* arena)
+{
+	ArenaTag tag = arena_set_tag(arena, ARENA_TAG_SPRITES);
+
+	sb->arena = arena_make(arena_push_array_uninit(arena, uint8_t, RT_MAX_SPRITE_MEM), RT_MAX_SPRITE_MEM);
+
+	arena_set_tag(arena, tag);
+
+	sb->sprite_count = 0;
+}
+
+RT_Bitmap* rt_sprite_bank_push(RT_SpriteBank* sb, uint16_t width, uint16_t height, bool indexed)
+{
+	const size_t size = (size_t)width * height + (indexed ? 256 : 0);
+
+	if (sb->sprite_count >= RT_MAX_SPRITES || sb->arena.offset + size >= sb->arena.capacity)
+	{
+		return nullptr;
+	}
+
+	RT_Bitmap* b = &sb->sprites[sb->sprite_count++];
+
+	b->width = width;
+	b->height = height;
+	b->key = -1;
+
+	b->pixels = arena_push_array(&sb->arena, uint8_t, width * height);
+	b->palette = indexed ? arena_push_array(&sb->arena, uint8_t, 256) : nullptr;
+
+	return b;
+}
+
+RT_Bitmap* rt_sprite_bank_get(RT_SpriteBank* sb, int32_t id)
+{
+	if (id < 0 || id >= sb->sprite_count)
+	{
+		return nullptr;
+	}
+
+	return &sb->sprites[id];
+}
@@ -0,0 +1,26 @@
+#pragma once
+
+#include <base/common.h>
+#include <base/arena.h>
+
+#include <runtime/canvas.h>
+#include <runtime/config.h>
+
+// sprites live in their own arena, separate from the one the VM uses, 
+// since anything a foreign procedure allocates from the VM arena is 
+// released as soon as the call returns.
+typedef struct RT_SpriteBank RT_SpriteBank;
+struct RT_SpriteBank
+{
+	Arena arena;
+
+	RT_Bitmap sprites[RT_MAX_SPRITES];
+	uint16_t sprite_count;
+};
+
+void rt_sprite_bank_init(RT_SpriteBank* sb, Arena* arena);
+
+// returns a bitmap for the caller to fill in (including the palette, if `indexed`), or nullptr if the bank is full
+RT_Bitmap* rt_sprite_bank_push(RT_SpriteBank* sb, uint16_t width, uint16_t height, bool indexed);
+
+RT_Bitmap* rt_sprite_bank_get(RT_SpriteBank* sb, int32_t id);
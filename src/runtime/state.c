@@ -2,6 +2,526 @@
 
 static RT_State* state;
 
+static void show_frame()
+{
+	rt_canvas_present(&state->canvas);
+
+	__atomic_store_n(&state->frames_presented, state->frames_presented + 1, __ATOMIC_RELEASE);
+}
+
+// waits for the batch being rasterized, and shows it if `present` ended it
+static void wait_render()
+{
+	if (!state->rendering)
+	{
+		return;
+	}
+
+	if (state->finish)
+	{
+		state->finish(state);
+	}
+
+	state->rendering = false;
+	state->tilemap_rendering = false;
+	state->canvas.pixels += __atomic_exchange_n(&state->rendered_pixels, 0, __ATOMIC_ACQUIRE);
+
+	if (state->rendering_frame)
+	{
+		show_frame();
+	}
+}
+
+// hands what was recorded so far over to be rasterized, and records into the other buffer
+static void flush(bool ends_frame)
+{
+	wait_render();
+
+	state->rendering = true;
+	state->rendering_frame = ends_frame;
+	state->tilemap_rendering = state->tilemap_recorded;
+	state->render_canvas = state->canvas;
+
+	state->recording ^= 1;
+	state->tilemap_recorded = false;
+
+	rt_command_buffer_reset(&state->commands[state->recording]);
+
+	if (state->render)
+	{
+		state->render(state);
+		return;
+	}
+
+	for (uint8_t i = 0; i < RT_RENDER_BANDS; i++)
+	{
+		rt_render_band(state, i);
+	}
+
+	wait_render();
+}
+
+// called before the tilemap (or its tileset) changes
+static void flush_tilemap()
+{
+	if (state->tilemap_recorded)
+	{
+		flush(false);
+	}
+
+	if (state->tilemap_rendering)
+	{
+		wait_render();
+	}
+}
+
+// draw calls either rasterize right away or get recorded for the frame, in deferred mode
+static void submit(PQ_VM* vm, RT_Command cmd)
+{
+	const RT_Canvas* c = &state->canvas;
+
+	cmd.fore_color = c->fore_color;
+	cmd.back_color = c->back_color;
+	cmd.shade = c->shade;
+	cmd.line_width = c->line_width;
+
+	if (!state->deferred)
+	{
+		rt_command_execute(&cmd, &state->canvas);
+		return;
+	}
+
+	state->tilemap_recorded |= cmd.type == RT_COMMAND_TILEMAP;
+
+	if (rt_command_buffer_push(&state->commands[state->recording], c, cmd))
+	{
+		return;
+	}
+
+	flush(false);
+
+	// too big for an empty buffer, nothing is left to draw before it once the rest is done
+	if (!rt_command_buffer_push(&state->commands[state->recording], c, cmd))
+	{
+		wait_render();
+
+		rt_command_execute(&cmd, &state->canvas);
+	}
+}
+
+// draws n primitives out of `array_count` parallel arrays (xs, ys...), converting 
+// them to commands of up to RT_MAX_BATCH_SIZE. consecutive line commands share 
+// their end points, so the strip stays connected.
+static void submit_batch(PQ_VM* vm, RT_CommandType type, const PQ_Value* arrays, uint8_t array_count, PQ_Value count)
+{
+	const int32_t n = pq_value_as_int(count);
+
+	for (uint8_t i = 0; i < array_count; i++)
+	{
+		if (!pq_value_is_array(arrays[i]) || n < 0 || n > arrays[i].a.count)
+		{
+			pq_vm_error(vm, "Invalid batch arrays");
+			return;
+		}
+	}
+
+	const int32_t overlap = type == RT_COMMAND_LINES ? 1 : 0;
+
+	int16_t data[4 * RT_MAX_BATCH_SIZE];
+
+	for (int32_t first = 0; first + overlap < n && !vm->halt; first += RT_MAX_BATCH_SIZE - overlap)
+	{
+		const uint16_t size = (uint16_t)MIN(n - first, (int32_t)RT_MAX_BATCH_SIZE);
+
+		for (uint8_t a = 0; a < array_count; a++)
+		{
+			for (uint16_t i = 0; i < size; i++)
+			{
+				data[a * size + i] = (int16_t)pq_value_as_int(pq_value_array_get(arrays[a], first + i));
+			}
+		}
+
+		submit(vm, (RT_Command){ type, .data = data, .data_size = size });
+	}
+}
+
+// a w * h block of colors, split into commands of whole rows
+static void submit_pixels(PQ_VM* vm, PQ_Value pixels, int16_t x, int16_t y, int16_t w, int16_t h)
+{
+	if (!pq_value_is_array(pixels) || w <= 0 || h <= 0 || w > RT_MAX_BATCH_PIXELS || pixels.a.count < w * h)
+	{
+		pq_vm_error(vm, "Invalid pixel array");
+		return;
+	}
+
+	const int16_t rows = RT_MAX_BATCH_PIXELS / w;
+
+	uint8_t data[RT_MAX_BATCH_PIXELS];
+
+	for (int16_t first = 0; first < h && !vm->halt; first += rows)
+	{
+		const int16_t count = MIN((int16_t)(h - first), rows);
+
+		for (int32_t i = 0; i < count * w; i++)
+		{
+			data[i] = (uint8_t)pq_value_as_int(pq_value_array_get(pixels, first * w + i));
+		}
+
+		submit(vm, (RT_Command){ RT_COMMAND_PIXELS, .args = { x, y + first, w, count }, .data = data, .data_size = count * w });
+	}
+}
+
+// checks the size given for a new sprite, before any of it is allocated or read
+static bool check_sprite_pixels(PQ_VM* vm, PQ_Value pixels, int32_t w, int32_t h)
+{
+	if (w <= 0 || h <= 0 || w > RT_SPRITE_MAX_DIM || h > RT_SPRITE_MAX_DIM)
+	{
+		pq_vm_error(vm, "Invalid sprite size");
+		return false;
+	}
+
+	if (!pq_value_is_array(pixels) || pixels.a.count < (uint32_t)w * h)
+	{
+		pq_vm_error(vm, "Sprite pixel array is too small");
+		return false;
+	}
+
+	return true;
+}
+
+// bulk array operations. packed arrays go through base/simd.h, plain ones
+// element by element with the usual promotion rules.
+#if defined PQ_FIXED_POINT
+	// fixed point saturates, so only the lane-wise exact kernels are shared with ints
+	static void numbers_add(PQ_Number* a, uint32_t n, PQ_Number v) { for (uint32_t i = 0; i < n; i++) a[i] = pq_number_add(a[i], v); }
+	static void numbers_mul(PQ_Number* a, uint32_t n, PQ_Number v) { for (uint32_t i = 0; i < n; i++) a[i] = pq_number_mul(a[i], v); }
+	static PQ_Number numbers_min(const PQ_Number* a, uint32_t n) { return simd_min_i32(a, n); }
+	static PQ_Number numbers_max(const PQ_Number* a, uint32_t n) { return simd_max_i32(a, n); }
+	static PQ_Number numbers_sum(const PQ_Number* a, uint32_t n) { return pq_number_saturate(simd_sum_i32(a, n)); }
+	static PQ_Number numbers_dot(const PQ_Number* a, const PQ_Number* b, uint32_t n) { return pq_number_saturate(simd_dot_i32(a, b, n) >> PQ_FIXED_FRACTION_BITS); }
+	static void numbers_fill(PQ_Number* a, uint32_t n, PQ_Number v) { simd_fill_i32(a, n, v); }
+#else
+	static void numbers_add(PQ_Number* a, uint32_t n, PQ_Number v) { simd_add_f32(a, n, v); }
+	static void numbers_mul(PQ_Number* a, uint32_t n, PQ_Number v) { simd_mul_f32(a, n, v); }
+	static PQ_Number numbers_min(const PQ_Number* a, uint32_t n) { return simd_min_f32(a, n); }
+	static PQ_Number numbers_max(const PQ_Number* a, uint32_t n) { return simd_max_f32(a, n); }
+	static PQ_Number numbers_sum(const PQ_Number* a, uint32_t n) { return simd_sum_f32(a, n); }
+	static PQ_Number numbers_dot(const PQ_Number* a, const PQ_Number* b, uint32_t n) { return simd_dot_f32(a, b, n); }
+	static void numbers_fill(PQ_Number* a, uint32_t n, PQ_Number v) { simd_fill_f32(a, n, v); }
+#endif
+
+// int results that don't fit an int anymore become numbers
+static PQ_Value int64_value(int64_t v)
+{
+	return v >= INT32_MIN && v <= INT32_MAX ? pq_value_int((int32_t)v) : pq_value_number((float)v);
+}
+
+static bool check_array(PQ_VM* vm, PQ_Value a)
+{
+	if (!pq_value_is_array(a))
+	{
+		pq_vm_error(vm, "Expected an array");
+		return false;
+	}
+
+	return true;
+}
+
+static void array_fill(PQ_Value a, PQ_Value v)
+{
+	switch (a.type)
+	{
+		case VALUE_INT_ARRAY:    simd_fill_u32((uint32_t*)a.a.ints, a.a.count, (uint32_t)pq_value_as_int(v)); break;
+		case VALUE_NUMBER_ARRAY: numbers_fill(a.a.numbers, a.a.count, pq_value_as_pq_number(v)); break;
+
+		default:
+			for (uint16_t i = 0; i < a.a.count; i++) a.a.elements[i] = v;
+	}
+}
+
+static void array_copy(PQ_Value dst, PQ_Value src)
+{
+	const uint16_t n = MIN(dst.a.count, src.a.count);
+
+	if (dst.type != src.type)
+	{
+		for (uint16_t i = 0; i < n; i++) pq_value_array_set(dst, i, pq_value_array_get(src, i));
+		return;
+	}
+
+	const size_t size = dst.type == VALUE_ARRAY ? sizeof(PQ_Value) : sizeof(int32_t);
+
+	__builtin_memmove(dst.a.elements, src.a.elements, n * size);
+}
+
+// adds v to, or multiplies it with, every element. int arrays only take the
+// simd path with an int v, otherwise each result is a number truncated on store.
+static void array_scale(PQ_Value a, PQ_Value v, bool mul)
+{
+	if (a.type == VALUE_INT_ARRAY && v.type == VALUE_INT)
+	{
+		(mul ? simd_mul_u32 : simd_add_u32)((uint32_t*)a.a.ints, a.a.count, (uint32_t)v.i);
+		return;
+	}
+
+	if (a.type == VALUE_NUMBER_ARRAY)
+	{
+		(mul ? numbers_mul : numbers_add)(a.a.numbers, a.a.count, pq_value_as_pq_number(v));
+		return;
+	}
+
+	for (uint16_t i = 0; i < a.a.count; i++)
+	{
+		const PQ_Value e = pq_value_array_get(a, i);
+
+		pq_value_array_set(a, i, mul ? pq_value_mul(e, v) : pq_value_add(e, v));
+	}
+}
+
+static PQ_Value array_sum(PQ_Value a)
+{
+	switch (a.type)
+	{
+		case VALUE_INT_ARRAY:    return int64_value(simd_sum_i32(a.a.ints, a.a.count));
+		case VALUE_NUMBER_ARRAY: return pq_value_from_pq_number(numbers_sum(a.a.numbers, a.a.count));
+
+		default:
+		{
+			PQ_Value r = pq_value_int(0);
+			for (uint16_t i = 0; i < a.a.count; i++) r = pq_value_add(r, a.a.elements[i]);
+			return r;
+		}
+	}
+}
+
+static PQ_Value array_dot(PQ_Value a, PQ_Value b)
+{
+	const uint16_t n = MIN(a.a.count, b.a.count);
+
+	if (a.type == b.type && a.type == VALUE_INT_ARRAY)
+	{
+		return int64_value(simd_dot_i32(a.a.ints, b.a.ints, n));
+	}
+
+	if (a.type == b.type && a.type == VALUE_NUMBER_ARRAY)
+	{
+		return pq_value_from_pq_number(numbers_dot(a.a.numbers, b.a.numbers, n));
+	}
+
+	PQ_Value r = pq_value_int(0);
+
+	for (uint16_t i = 0; i < n; i++)
+	{
+		r = pq_value_add(r, pq_value_mul(pq_value_array_get(a, i), pq_value_array_get(b, i)));
+	}
+
+	return r;
+}
+
+static PQ_Value array_extreme(PQ_Value a, bool max)
+{
+	if (a.a.count == 0)
+	{
+		return pq_value_null();
+	}
+
+	switch (a.type)
+	{
+		case VALUE_INT_ARRAY:    return pq_value_int((max ? simd_max_i32 : simd_min_i32)(a.a.ints, a.a.count));
+		case VALUE_NUMBER_ARRAY: return pq_value_from_pq_number((max ? numbers_max : numbers_min)(a.a.numbers, a.a.count));
+
+		default:
+		{
+			PQ_Value r = a.a.elements[0];
+
+			for (uint16_t i = 1; i < a.a.count; i++)
+			{
+				const PQ_Value e = a.a.elements[i];
+				r = (max ? pq_value_greater(e, r) : pq_value_less(e, r)).b ? e : r;
+			}
+
+			return r;
+		}
+	}
+}
+
+// copies the first n elements of the parallel arrays (xs, ys, ws, hs or xs, ys, rs) into bodies
+static bool gather_bodies(PQ_VM* vm, RT_Bodies* b, const PQ_Value* arrays, PQ_Value count, bool circles)
+{
+	const int32_t n = pq_value_as_int(count);
+	const uint8_t array_count = circles ? 3 : 4;
+
+	for (uint8_t i = 0; i < array_count; i++)
+	{
+		if (!pq_value_is_array(arrays[i]) || n < 0 || n > arrays[i].a.count || n > RT_MAX_COLLISION_BODIES)
+		{
+			pq_vm_error(vm, "Invalid collision arrays");
+			return false;
+		}
+	}
+
+	rt_bodies_init(b, vm->arena, (uint16_t)n, circles);
+
+	PQ_Number* fields[] = { b->x, b->y, b->w, b->h };
+
+	for (uint8_t a = 0; a < array_count; a++)
+	{
+		if (arrays[a].type == VALUE_NUMBER_ARRAY)
+		{
+			__builtin_memcpy(fields[a], arrays[a].a.numbers, n * sizeof(PQ_Number));
+			continue;
+		}
+
+		for (int32_t i = 0; i < n; i++)
+		{
+			fields[a][i] = pq_value_as_pq_number(pq_value_array_get(arrays[a], i));
+		}
+	}
+
+	return true;
+}
+
+// the overlapping pairs go into `out` as consecutive indices, returns how many pairs there are
+static PQ_Value find_pairs(PQ_VM* vm, const PQ_Value* arrays, PQ_Value count, PQ_Value out, bool circles)
+{
+	if (!check_array(vm, out))
+	{
+		return pq_value_null();
+	}
+
+	Scratch scratch = scratch_make(vm->arena);
+
+	RT_Bodies b;
+	uint16_t found = 0;
+
+	if (gather_bodies(vm, &b, arrays, count, circles))
+	{
+		const uint16_t max_pairs = MIN((uint16_t)(out.a.count / 2), RT_MAX_COLLISION_PAIRS);
+
+		uint16_t* pairs = arena_push_array_uninit(vm->arena, uint16_t, 2 * max_pairs);
+
+		found = rt_bodies_pairs(&b, vm->arena, pairs, max_pairs);
+
+		for (uint16_t i = 0; i < 2 * found; i++)
+		{
+			pq_value_array_set(out, i, pq_value_int(pairs[i]));
+		}
+	}
+
+	scratch_release(scratch);
+
+	return pq_value_int(found);
+}
+
+// the live particles as points of their own colors, the ones off the canvas are left out
+static void submit_particles(PQ_VM* vm)
+{
+	const RT_Particles* p = &state->particles;
+
+	int16_t data[2 * RT_MAX_BATCH_SIZE + RT_MAX_BATCH_SIZE / 2];
+	uint16_t visible[RT_MAX_BATCH_SIZE];
+
+	for (uint16_t first = 0; first < p->count && !vm->halt;)
+	{
+		uint16_t size = 0;
+
+		for (; first < p->count && size < RT_MAX_BATCH_SIZE; first++)
+		{
+			const int32_t x = pq_number_to_int(p->x[first]);
+			const int32_t y = pq_number_to_int(p->y[first]);
+
+			if (x >= 0 && y >= 0 && x < state->canvas.width && y < state->canvas.height)
+			{
+				visible[size++] = first;
+			}
+		}
+
+		uint8_t* colors = (uint8_t*)(data + 2 * size);
+
+		for (uint16_t i = 0; i < size; i++)
+		{
+			data[i] = (int16_t)pq_number_to_int(p->x[visible[i]]);
+			data[size + i] = (int16_t)pq_number_to_int(p->y[visible[i]]);
+			colors[i] = rt_particles_color(p, visible[i]);
+		}
+
+		if (size > 0)
+		{
+			submit(vm, (RT_Command){ RT_COMMAND_PARTICLES, .data = data, .data_size = size });
+		}
+	}
+}
+
+static void tick()
+{
+	if (!state->clock)
+	{
+		return;
+	}
+
+	const double now = state->clock();
+
+	if (state->last_present > 0.0)
+	{
+		state->delta_time = (float)(now - state->last_present);
+		state->time_since_start += state->delta_time;
+	}
+
+	state->last_present = now;
+}
+
+static void record_stats(PQ_VM* vm)
+{
+	RT_FrameStats* f = &state->stats;
+
+	f->instructions = vm->instructions_executed - state->frame_instructions;
+	f->native_calls = vm->native_calls - state->frame_native_calls;
+	f->pixels = state->canvas.pixels;
+
+	f->present_latency = state->clock ? (float)(state->clock() - state->last_present) : 0.0f;
+
+	state->frame_instructions = vm->instructions_executed;
+	state->frame_native_calls = vm->native_calls;
+	state->canvas.pixels = 0;
+}
+
+// frames are traced from the end of one present to the end of the next
+static void present(PQ_VM* vm)
+{
+	tick();
+
+	if (state->deferred)
+	{
+		flush(true);
+	}
+	else
+	{
+		show_frame();
+	}
+
+	// with vsync, frames nobody would see aren't made in the first place
+	if (state->vsync && state->wait && state->frames_presented > 0)
+	{
+		state->wait(state, state->frames_presented);
+	}
+
+	record_stats(vm);
+
+	PQ_TRACE_FRAME(s("frame"));
+}
+
+static void set_deferred(bool deferred)
+{
+	// draw whatever was recorded so far
+	if (state->deferred && !deferred)
+	{
+		flush(false);
+		wait_render();
+	}
+
+	state->deferred = deferred;
+}
+
 #define DEFINE_RT_PROCEDURES \
 	PROC(print, 1, \
 	{ \
@@ -9,223 +529,659 @@ static RT_State* state;
 		\
 		char out[1024]; \
 		\
-		sprintf(out, "%.*s\n", s_fmt(pq_value_as_string(scratch.arena, pq_vm_get_local(vm, 0)))); \
+		sprintf(out, "%.*s\n", s_fmt(pq_value_as_string(scratch.arena, args[0]))); \
 		\
 		rt_print(out); \
 		\
 		scratch_release(scratch); \
 		\
-		pq_vm_return(vm); \
+		return pq_value_null(); \
 	}) \
 	\
 	PROC(color, 3, \
 	{ \
-		const uint8_t r = (uint8_t)pq_value_as_number(pq_vm_get_local(vm, 0)); \
-		const uint8_t g = (uint8_t)pq_value_as_number(pq_vm_get_local(vm, 1)); \
-		const uint8_t b = (uint8_t)pq_value_as_number(pq_vm_get_local(vm, 2)); \
+		const uint8_t r = (uint8_t)pq_value_as_number(args[0]); \
+		const uint8_t g = (uint8_t)pq_value_as_number(args[1]); \
+		const uint8_t b = (uint8_t)pq_value_as_number(args[2]); \
 		\
-		pq_vm_return_value(vm, pq_value_number(rt_canvas_pack_color(r, g, b))); \
+		return pq_value_number(rt_canvas_pack_color(r, g, b)); \
 	}) \
 	PROC(back, 1, \
 	{ \
-		state->canvas.back_color = (uint8_t)pq_value_as_number(pq_vm_get_local(vm, 0)); \
+		state->canvas.back_color = (uint8_t)pq_value_as_number(args[0]); \
 		\
-		pq_vm_return(vm); \
+		return pq_value_null(); \
 	}) \
 	PROC(fore, 1, \
 	{ \
-		state->canvas.fore_color = (uint8_t)pq_value_as_number(pq_vm_get_local(vm, 0)); \
+		state->canvas.fore_color = (uint8_t)pq_value_as_number(args[0]); \
 		\
-		pq_vm_return(vm); \
+		return pq_value_null(); \
 	}) \
 	PROC(line_width, 1, \
 	{ \
-		state->canvas.line_width = (uint8_t)pq_value_as_number(pq_vm_get_local(vm, 0)); \
+		state->canvas.line_width = (uint8_t)pq_value_as_number(args[0]); \
 		\
-		pq_vm_return(vm); \
+		return pq_value_null(); \
 	}) \
 	PROC(clear, 0, \
 	{ \
-		rt_canvas_clear(&state->canvas); \
+		submit(vm, (RT_Command){ RT_COMMAND_CLEAR }); \
 		\
-		pq_vm_return(vm); \
+		return pq_value_null(); \
 	}) \
 	PROC(present, 0, \
 	{ \
-		rt_canvas_present(&state->canvas); \
+		present(vm); \
+		\
+		return pq_value_null(); \
+	}) \
+	PROC(deferred, 1, \
+	{ \
+		set_deferred(pq_value_as_boolean(args[0])); \
 		\
-		pq_vm_return(vm); \
+		return pq_value_null(); \
 	}) \
 	PROC(line, 4, \
 	{ \
-		const int16_t x0 = (int16_t)pq_value_as_number(pq_vm_get_local(vm, 0)); \
-		const int16_t y0 = (int16_t)pq_value_as_number(pq_vm_get_local(vm, 1)); \
-		const int16_t x1 = (int16_t)pq_value_as_number(pq_vm_get_local(vm, 2)); \
-		const int16_t y1 = (int16_t)pq_value_as_number(pq_vm_get_local(vm, 3)); \
+		const int16_t x0 = (int16_t)pq_value_as_number(args[0]); \
+		const int16_t y0 = (int16_t)pq_value_as_number(args[1]); \
+		const int16_t x1 = (int16_t)pq_value_as_number(args[2]); \
+		const int16_t y1 = (int16_t)pq_value_as_number(args[3]); \
 		\
-		rt_canvas_line(&state->canvas, x0, y0, x1, y1); \
+		submit(vm, (RT_Command){ RT_COMMAND_LINE, .args = { x0, y0, x1, y1 } }); \
 		\
-		pq_vm_return(vm); \
+		return pq_value_null(); \
 	}) \
 	PROC(rect, 4, \
 	{ \
-		const int16_t x = (int16_t)pq_value_as_number(pq_vm_get_local(vm, 0)); \
-		const int16_t y = (int16_t)pq_value_as_number(pq_vm_get_local(vm, 1)); \
-		const int16_t w = (int16_t)pq_value_as_number(pq_vm_get_local(vm, 2)); \
-		const int16_t h = (int16_t)pq_value_as_number(pq_vm_get_local(vm, 3)); \
+		const int16_t x = (int16_t)pq_value_as_number(args[0]); \
+		const int16_t y = (int16_t)pq_value_as_number(args[1]); \
+		const int16_t w = (int16_t)pq_value_as_number(args[2]); \
+		const int16_t h = (int16_t)pq_value_as_number(args[3]); \
 		\
-		rt_canvas_rect(&state->canvas, x, y, w, h); \
+		submit(vm, (RT_Command){ RT_COMMAND_RECT, .args = { x, y, w, h } }); \
 		\
-		pq_vm_return(vm); \
+		return pq_value_null(); \
 	}) \
 	PROC(fill_rect, 4, \
 	{ \
-		const int16_t x = (int16_t)pq_value_as_number(pq_vm_get_local(vm, 0)); \
-		const int16_t y = (int16_t)pq_value_as_number(pq_vm_get_local(vm, 1)); \
-		const int16_t w = (int16_t)pq_value_as_number(pq_vm_get_local(vm, 2)); \
-		const int16_t h = (int16_t)pq_value_as_number(pq_vm_get_local(vm, 3)); \
+		const int16_t x = (int16_t)pq_value_as_number(args[0]); \
+		const int16_t y = (int16_t)pq_value_as_number(args[1]); \
+		const int16_t w = (int16_t)pq_value_as_number(args[2]); \
+		const int16_t h = (int16_t)pq_value_as_number(args[3]); \
 		\
-		rt_canvas_fill_rect(&state->canvas, x, y, w, h); \
+		submit(vm, (RT_Command){ RT_COMMAND_FILL_RECT, .args = { x, y, w, h } }); \
 		\
-		pq_vm_return(vm); \
+		return pq_value_null(); \
 	}) \
 	PROC(put, 2, \
 	{ \
-		int16_t x = (int16_t)pq_value_as_number(pq_vm_get_local(vm, 0)); \
-		int16_t y = (int16_t)pq_value_as_number(pq_vm_get_local(vm, 1)); \
+		int16_t x = (int16_t)pq_value_as_number(args[0]); \
+		int16_t y = (int16_t)pq_value_as_number(args[1]); \
 		\
-		rt_canvas_put(&state->canvas, x, y); \
+		submit(vm, (RT_Command){ RT_COMMAND_PUT, .args = { x, y } }); \
 		\
-		pq_vm_return(vm); \
+		return pq_value_null(); \
 	}) \
 	PROC(circle, 3, \
 	{ \
-		int16_t cx = (int16_t)pq_value_as_number(pq_vm_get_local(vm, 0)); \
-		int16_t cy = (int16_t)pq_value_as_number(pq_vm_get_local(vm, 1)); \
-		int16_t r = (int16_t)pq_value_as_number(pq_vm_get_local(vm, 2)); \
+		int16_t cx = (int16_t)pq_value_as_number(args[0]); \
+		int16_t cy = (int16_t)pq_value_as_number(args[1]); \
+		int16_t r = (int16_t)pq_value_as_number(args[2]); \
 		\
-		rt_canvas_circle(&state->canvas, cx, cy, r); \
+		submit(vm, (RT_Command){ RT_COMMAND_CIRCLE, .args = { cx, cy, r } }); \
 		\
-		pq_vm_return(vm); \
+		return pq_value_null(); \
 	}) \
 	PROC(fill_circle, 3, \
 	{ \
-		int16_t cx = (int16_t)pq_value_as_number(pq_vm_get_local(vm, 0)); \
-		int16_t cy = (int16_t)pq_value_as_number(pq_vm_get_local(vm, 1)); \
-		int16_t r = (int16_t)pq_value_as_number(pq_vm_get_local(vm, 2)); \
+		int16_t cx = (int16_t)pq_value_as_number(args[0]); \
+		int16_t cy = (int16_t)pq_value_as_number(args[1]); \
+		int16_t r = (int16_t)pq_value_as_number(args[2]); \
 		\
-		rt_canvas_fill_circle(&state->canvas, cx, cy, r); \
+		submit(vm, (RT_Command){ RT_COMMAND_FILL_CIRCLE, .args = { cx, cy, r } }); \
 		\
-		pq_vm_return(vm); \
+		return pq_value_null(); \
+	}) \
+	PROC(fill_triangle, 6, \
+	{ \
+		const int16_t x0 = (int16_t)pq_value_as_number(args[0]); \
+		const int16_t y0 = (int16_t)pq_value_as_number(args[1]); \
+		const int16_t x1 = (int16_t)pq_value_as_number(args[2]); \
+		const int16_t y1 = (int16_t)pq_value_as_number(args[3]); \
+		const int16_t x2 = (int16_t)pq_value_as_number(args[4]); \
+		const int16_t y2 = (int16_t)pq_value_as_number(args[5]); \
+		\
+		submit(vm, (RT_Command){ RT_COMMAND_FILL_TRIANGLE, .args = { x0, y0, x1, y1, x2, y2 } }); \
+		\
+		return pq_value_null(); \
+	}) \
+	PROC(fill_polygon, 3, \
+	{ \
+		PQ_Value xs = args[0]; \
+		PQ_Value ys = args[1]; \
+		const uint16_t n = (uint16_t)pq_value_as_number(args[2]); \
+		\
+		if (!pq_value_is_array(xs) || !pq_value_is_array(ys) || n > xs.a.count || n > ys.a.count || n > RT_MAX_POLYGON_POINTS) \
+		{ \
+			pq_vm_error(vm, "Invalid polygon"); \
+			return pq_value_null(); \
+		} \
+		\
+		int16_t points[2 * RT_MAX_POLYGON_POINTS]; \
+		\
+		for (uint16_t i = 0; i < n; i++) \
+		{ \
+			points[i] = (int16_t)pq_value_as_number(pq_value_array_get(xs, i)); \
+			points[n + i] = (int16_t)pq_value_as_number(pq_value_array_get(ys, i)); \
+		} \
+		\
+		submit(vm, (RT_Command){ RT_COMMAND_FILL_POLYGON, .data = points, .data_size = n }); \
+		\
+		return pq_value_null(); \
+	}) \
+	PROC(shade, 1, \
+	{ \
+		state->canvas.shade = (uint8_t)CLAMP(pq_value_as_number(args[0]), 0.0f, 16.0f); \
+		\
+		return pq_value_null(); \
 	}) \
 	PROC(text, 4, \
 	{ \
 		Scratch scratch = scratch_make(vm->arena); \
 		\
-		int16_t x = (int16_t)pq_value_as_number(pq_vm_get_local(vm, 0)); \
-		int16_t y = (int16_t)pq_value_as_number(pq_vm_get_local(vm, 1)); \
-		int16_t s = (int16_t)pq_value_as_number(pq_vm_get_local(vm, 2)); \
-		String text = pq_value_as_string(scratch.arena, pq_vm_get_local(vm, 3)); \
+		int16_t x = (int16_t)pq_value_as_number(args[0]); \
+		int16_t y = (int16_t)pq_value_as_number(args[1]); \
+		int16_t s = (int16_t)pq_value_as_number(args[2]); \
+		String text = pq_value_as_string(scratch.arena, args[3]); \
+		\
+		submit(vm, (RT_Command){ RT_COMMAND_TEXT, .args = { x, y, s }, .data = text.buffer, .data_size = (uint16_t)text.length }); \
+		\
+		scratch_release(scratch); \
+		\
+		return pq_value_null(); \
+	}) \
+	PROC(text_width, 2, \
+	{ \
+		Scratch scratch = scratch_make(vm->arena); \
+		\
+		int16_t s = (int16_t)pq_value_as_number(args[0]); \
+		String text = pq_value_as_string(scratch.arena, args[1]); \
+		\
+		RT_TextSize size = rt_canvas_measure_text(s, text); \
+		\
+		scratch_release(scratch); \
+		\
+		return pq_value_number(size.width); \
+	}) \
+	PROC(text_height, 2, \
+	{ \
+		Scratch scratch = scratch_make(vm->arena); \
+		\
+		int16_t s = (int16_t)pq_value_as_number(args[0]); \
+		String text = pq_value_as_string(scratch.arena, args[1]); \
 		\
-		rt_canvas_text(&state->canvas, x, y, s, text); \
+		RT_TextSize size = rt_canvas_measure_text(s, text); \
 		\
 		scratch_release(scratch); \
 		\
-		pq_vm_return(vm); \
+		return pq_value_number(size.height); \
 	}) \
 	\
-	PROC(abs, 1, \
+	PROC(sprite, 3, \
 	{ \
-		pq_vm_return_value(vm, pq_value_number(__builtin_fabsf(pq_value_as_number(pq_vm_get_local(vm, 0))))); \
+		PQ_Value pixels = args[0]; \
+		const int32_t w = pq_value_as_int(args[1]); \
+		const int32_t h = pq_value_as_int(args[2]); \
+		\
+		if (!check_sprite_pixels(vm, pixels, w, h)) \
+		{ \
+			return pq_value_null(); \
+		} \
+		\
+		const uint32_t count = (uint32_t)w * h; \
+		\
+		RT_Bitmap* b = rt_sprite_bank_push(&state->sprites, (uint16_t)w, (uint16_t)h, false); \
+		\
+		if (!b) \
+		{ \
+			pq_vm_error(vm, "Out of sprite memory"); \
+			return pq_value_null(); \
+		} \
+		\
+		for (uint32_t i = 0; i < count; i++) \
+		{ \
+			b->pixels[i] = (uint8_t)pq_value_as_number(pq_value_array_get(pixels, i)); \
+		} \
+		\
+		return pq_value_number(state->sprites.sprite_count - 1); \
 	}) \
-	PROC(floor, 1, \
+	PROC(sprite_indexed, 4, \
 	{ \
-		pq_vm_return_value(vm, pq_value_number(__builtin_floorf(pq_value_as_number(pq_vm_get_local(vm, 0))))); \
+		PQ_Value pixels = args[0]; \
+		const int32_t w = pq_value_as_int(args[1]); \
+		const int32_t h = pq_value_as_int(args[2]); \
+		PQ_Value palette = args[3]; \
+		\
+		if (!check_sprite_pixels(vm, pixels, w, h)) \
+		{ \
+			return pq_value_null(); \
+		} \
+		\
+		const uint32_t count = (uint32_t)w * h; \
+		\
+		if (!pq_value_is_array(palette)) \
+		{ \
+			pq_vm_error(vm, "Sprite palette must be an array"); \
+			return pq_value_null(); \
+		} \
+		\
+		RT_Bitmap* b = rt_sprite_bank_push(&state->sprites, (uint16_t)w, (uint16_t)h, true); \
+		\
+		if (!b) \
+		{ \
+			pq_vm_error(vm, "Out of sprite memory"); \
+			return pq_value_null(); \
+		} \
+		\
+		for (uint16_t i = 0; i < 256; i++) \
+		{ \
+			b->palette[i] = i < palette.a.count ? (uint8_t)pq_value_as_number(pq_value_array_get(palette, i)) : 0; \
+		} \
+		\
+		for (uint32_t i = 0; i < count; i++) \
+		{ \
+			b->pixels[i] = (uint8_t)pq_value_as_number(pq_value_array_get(pixels, i)); \
+		} \
+		\
+		return pq_value_number(state->sprites.sprite_count - 1); \
 	}) \
-	PROC(ceil, 1, \
+	PROC(sprite_key, 2, \
 	{ \
-		pq_vm_return_value(vm, pq_value_number(__builtin_ceilf(pq_value_as_number(pq_vm_get_local(vm, 0))))); \
+		RT_Bitmap* b = rt_sprite_bank_get(&state->sprites, (int32_t)pq_value_as_number(args[0])); \
+		\
+		if (b) \
+		{ \
+			flush_tilemap(); \
+			wait_render(); \
+			\
+			b->key = (int16_t)pq_value_as_number(args[1]); \
+		} \
+		\
+		return pq_value_null(); \
 	}) \
-	PROC(sqrt, 1, \
+	PROC(draw_sprite, 4, \
 	{ \
-		pq_vm_return_value(vm, pq_value_number(__builtin_sqrtf(pq_value_as_number(pq_vm_get_local(vm, 0))))); \
+		RT_Bitmap* b = rt_sprite_bank_get(&state->sprites, (int32_t)pq_value_as_number(args[0])); \
+		\
+		const int16_t x = (int16_t)pq_value_as_number(args[1]); \
+		const int16_t y = (int16_t)pq_value_as_number(args[2]); \
+		const uint8_t flags = (uint8_t)pq_value_as_number(args[3]); \
+		\
+		if (b) \
+		{ \
+			submit(vm, (RT_Command){ RT_COMMAND_BLIT, .flags = flags, .args = { 0, 0, b->width, b->height, x, y }, .key = b->key, .data = b }); \
+		} \
+		\
+		return pq_value_null(); \
 	}) \
-	PROC(sin, 1, \
+	PROC(draw_sprite_region, 8, \
 	{ \
-		pq_vm_return_value(vm, pq_value_number(__builtin_sinf(pq_value_as_number(pq_vm_get_local(vm, 0))))); \
+		RT_Bitmap* b = rt_sprite_bank_get(&state->sprites, (int32_t)pq_value_as_number(args[0])); \
+		\
+		const int16_t sx = (int16_t)pq_value_as_number(args[1]); \
+		const int16_t sy = (int16_t)pq_value_as_number(args[2]); \
+		const int16_t w = (int16_t)pq_value_as_number(args[3]); \
+		const int16_t h = (int16_t)pq_value_as_number(args[4]); \
+		const int16_t x = (int16_t)pq_value_as_number(args[5]); \
+		const int16_t y = (int16_t)pq_value_as_number(args[6]); \
+		const uint8_t flags = (uint8_t)pq_value_as_number(args[7]); \
+		\
+		if (b) \
+		{ \
+			submit(vm, (RT_Command){ RT_COMMAND_BLIT, .flags = flags, .args = { sx, sy, w, h, x, y }, .key = b->key, .data = b }); \
+		} \
+		\
+		return pq_value_null(); \
 	}) \
-	PROC(cos, 1, \
+	\
+	PROC(tilemap, 5, \
 	{ \
-		pq_vm_return_value(vm, pq_value_number(__builtin_cosf(pq_value_as_number(pq_vm_get_local(vm, 0))))); \
+		RT_Bitmap* b = rt_sprite_bank_get(&state->sprites, (int32_t)pq_value_as_number(args[0])); \
+		\
+		const uint8_t tw = (uint8_t)pq_value_as_number(args[1]); \
+		const uint8_t th = (uint8_t)pq_value_as_number(args[2]); \
+		const uint16_t columns = (uint16_t)pq_value_as_number(args[3]); \
+		const uint16_t rows = (uint16_t)pq_value_as_number(args[4]); \
+		\
+		flush_tilemap(); \
+		\
+		if (!b || !rt_tilemap_setup(&state->tilemap, b, tw, th, columns, rows)) \
+		{ \
+			pq_vm_error(vm, "Invalid tilemap"); \
+		} \
+		\
+		return pq_value_null(); \
 	}) \
-	PROC(tan, 1, \
+	PROC(set_tile, 3, \
 	{ \
-		pq_vm_return_value(vm, pq_value_number(__builtin_tanf(pq_value_as_number(pq_vm_get_local(vm, 0))))); \
+		const int16_t column = (int16_t)pq_value_as_number(args[0]); \
+		const int16_t row = (int16_t)pq_value_as_number(args[1]); \
+		const int16_t tile = (int16_t)pq_value_as_number(args[2]); \
+		\
+		flush_tilemap(); \
+		\
+		rt_tilemap_set(&state->tilemap, column, row, tile < 0 ? RT_TILE_NONE : (uint8_t)tile); \
+		\
+		return pq_value_null(); \
 	}) \
-	PROC(asin, 1, \
+	PROC(get_tile, 2, \
+	{ \
+		const int16_t column = (int16_t)pq_value_as_number(args[0]); \
+		const int16_t row = (int16_t)pq_value_as_number(args[1]); \
+		\
+		const uint8_t tile = rt_tilemap_get(&state->tilemap, column, row); \
+		\
+		return pq_value_number(tile == RT_TILE_NONE ? -1 : tile); \
+	}) \
+	PROC(load_tiles, 1, \
 	{ \
-		pq_vm_return_value(vm, pq_value_number(__builtin_asinf(pq_value_as_number(pq_vm_get_local(vm, 0))))); \
+		PQ_Value tiles = args[0]; \
+		\
+		RT_Tilemap* tm = &state->tilemap; \
+		\
+		if (!pq_value_is_array(tiles)) \
+		{ \
+			pq_vm_error(vm, "Tiles must be an array"); \
+			return pq_value_null(); \
+		} \
+		\
+		flush_tilemap(); \
+		\
+		for (uint16_t i = 0; i < tiles.a.count && i < tm->columns * tm->rows; i++) \
+		{ \
+			const int16_t tile = (int16_t)pq_value_as_number(pq_value_array_get(tiles, i)); \
+			\
+			rt_tilemap_set(tm, i % tm->columns, i / tm->columns, tile < 0 ? RT_TILE_NONE : (uint8_t)tile); \
+		} \
+		\
+		return pq_value_null(); \
 	}) \
-	PROC(acos, 1, \
+	PROC(scroll, 2, \
+	{ \
+		state->tilemap.scroll_x = (int16_t)pq_value_as_number(args[0]); \
+		state->tilemap.scroll_y = (int16_t)pq_value_as_number(args[1]); \
+		\
+		return pq_value_null(); \
+	}) \
+	PROC(draw_tilemap, 0, \
+	{ \
+		rt_tilemap_classify(&state->tilemap); \
+		\
+		submit(vm, (RT_Command){ RT_COMMAND_TILEMAP, .args = { state->tilemap.scroll_x, state->tilemap.scroll_y }, .data = &state->tilemap }); \
+		\
+		return pq_value_null(); \
+	}) \
+	\
+	PROC(asin, 1, \
 	{ \
-		pq_vm_return_value(vm, pq_value_number(__builtin_acosf(pq_value_as_number(pq_vm_get_local(vm, 0))))); \
+		return pq_value_number(__builtin_asinf(pq_value_as_number(args[0]))); \
 	}) \
-	PROC(atan, 1, \
+	PROC(acos, 1, \
 	{ \
-		pq_vm_return_value(vm, pq_value_number(__builtin_atanf(pq_value_as_number(pq_vm_get_local(vm, 0))))); \
+		return pq_value_number(__builtin_acosf(pq_value_as_number(args[0]))); \
 	}) \
 	PROC(pow, 2, \
 	{ \
-		pq_vm_return_value(vm, pq_value_number(__builtin_powf(pq_value_as_number(pq_vm_get_local(vm, 0)), pq_value_as_number(pq_vm_get_local(vm, 1))))); \
+		return pq_value_number(__builtin_powf(pq_value_as_number(args[0]), pq_value_as_number(args[1]))); \
 	}) \
 	PROC(log, 1, \
 	{ \
-		pq_vm_return_value(vm, pq_value_number(__builtin_logf(pq_value_as_number(pq_vm_get_local(vm, 0))))); \
+		return pq_value_number(__builtin_logf(pq_value_as_number(args[0]))); \
 	}) \
 	PROC(log10, 1, \
 	{ \
-		pq_vm_return_value(vm, pq_value_number(__builtin_log10f(pq_value_as_number(pq_vm_get_local(vm, 0))))); \
+		return pq_value_number(__builtin_log10f(pq_value_as_number(args[0]))); \
 	}) \
 	PROC(rad, 1, \
 	{ \
-		pq_vm_return_value(vm, pq_value_number(pq_value_as_number(pq_vm_get_local(vm, 0)) * 0.0174533f)); \
+		return pq_value_from_pq_number(pq_number_mul(pq_value_as_pq_number(args[0]), pq_number_from_float(0.0174533f))); \
 	}) \
 	PROC(deg, 1, \
 	{ \
-		pq_vm_return_value(vm, pq_value_number(pq_value_as_number(pq_vm_get_local(vm, 0)) * 57.2958f)); \
+		return pq_value_from_pq_number(pq_number_mul(pq_value_as_pq_number(args[0]), pq_number_from_float(57.2958f))); \
 	}) \
 	PROC(PI, 1, \
 	{ \
-		pq_vm_return_value(vm, pq_value_number(3.14159265359f)); \
+		return pq_value_number(3.14159265359f); \
 	}) \
 	\
 	PROC(left_key, 0, \
 	{ \
-		pq_vm_return_value(vm, pq_value_boolean(state->left_key)); \
+		return pq_value_boolean(state->left_key); \
 	}) \
 	PROC(right_key, 0, \
 	{ \
-		pq_vm_return_value(vm, pq_value_boolean(state->right_key)); \
+		return pq_value_boolean(state->right_key); \
 	}) \
 	PROC(up_key, 0, \
 	{ \
-		pq_vm_return_value(vm, pq_value_boolean(state->up_key)); \
+		return pq_value_boolean(state->up_key); \
 	}) \
 	PROC(down_key, 0, \
 	{ \
-		pq_vm_return_value(vm, pq_value_boolean(state->down_key)); \
+		return pq_value_boolean(state->down_key); \
 	}) \
 	PROC(a_key, 0, \
 	{ \
-		pq_vm_return_value(vm, pq_value_boolean(state->a_key)); \
+		return pq_value_boolean(state->a_key); \
 	}) \
 	PROC(b_key, 0, \
 	{ \
-		pq_vm_return_value(vm, pq_value_boolean(state->b_key)); \
+		return pq_value_boolean(state->b_key); \
+	}) \
+	\
+	PROC(points, 3, \
+	{ \
+		submit_batch(vm, RT_COMMAND_POINTS, args, 2, args[2]); \
+		\
+		return pq_value_null(); \
+	}) \
+	PROC(lines, 3, \
+	{ \
+		submit_batch(vm, RT_COMMAND_LINES, args, 2, args[2]); \
+		\
+		return pq_value_null(); \
+	}) \
+	PROC(fill_rects, 5, \
+	{ \
+		submit_batch(vm, RT_COMMAND_FILL_RECTS, args, 4, args[4]); \
+		\
+		return pq_value_null(); \
+	}) \
+	PROC(blit_pixels, 5, \
+	{ \
+		const int16_t x = (int16_t)pq_value_as_int(args[1]); \
+		const int16_t y = (int16_t)pq_value_as_int(args[2]); \
+		const int16_t w = (int16_t)pq_value_as_int(args[3]); \
+		const int16_t h = (int16_t)pq_value_as_int(args[4]); \
+		\
+		submit_pixels(vm, args[0], x, y, w, h); \
+		\
+		return pq_value_null(); \
+	}) \
+	\
+	PROC(array_fill, 2, \
+	{ \
+		if (check_array(vm, args[0])) array_fill(args[0], args[1]); \
+		\
+		return pq_value_null(); \
+	}) \
+	PROC(array_copy, 2, \
+	{ \
+		if (check_array(vm, args[0]) && check_array(vm, args[1])) array_copy(args[0], args[1]); \
+		\
+		return pq_value_null(); \
+	}) \
+	PROC(array_add, 2, \
+	{ \
+		if (check_array(vm, args[0])) array_scale(args[0], args[1], false); \
+		\
+		return pq_value_null(); \
+	}) \
+	PROC(array_mul, 2, \
+	{ \
+		if (check_array(vm, args[0])) array_scale(args[0], args[1], true); \
+		\
+		return pq_value_null(); \
+	}) \
+	PROC(array_sum, 1, \
+	{ \
+		return check_array(vm, args[0]) ? array_sum(args[0]) : pq_value_null(); \
+	}) \
+	PROC(array_dot, 2, \
+	{ \
+		return check_array(vm, args[0]) && check_array(vm, args[1]) ? array_dot(args[0], args[1]) : pq_value_null(); \
+	}) \
+	PROC(array_min, 1, \
+	{ \
+		return check_array(vm, args[0]) ? array_extreme(args[0], false) : pq_value_null(); \
+	}) \
+	PROC(array_max, 1, \
+	{ \
+		return check_array(vm, args[0]) ? array_extreme(args[0], true) : pq_value_null(); \
+	}) \
+	\
+	PROC(box_hit, 9, \
+	{ \
+		Scratch scratch = scratch_make(vm->arena); \
+		\
+		RT_Bodies b; \
+		PQ_Value hit = pq_value_null(); \
+		\
+		if (gather_bodies(vm, &b, args, args[4], false)) \
+		{ \
+			hit = pq_value_int(rt_bodies_first_hit(&b, pq_value_as_pq_number(args[5]), pq_value_as_pq_number(args[6]), pq_value_as_pq_number(args[7]), pq_value_as_pq_number(args[8]))); \
+		} \
+		\
+		scratch_release(scratch); \
+		\
+		return hit; \
+	}) \
+	PROC(circle_hit, 7, \
+	{ \
+		Scratch scratch = scratch_make(vm->arena); \
+		\
+		RT_Bodies b; \
+		PQ_Value hit = pq_value_null(); \
+		\
+		if (gather_bodies(vm, &b, args, args[3], true)) \
+		{ \
+			const PQ_Number r = pq_value_as_pq_number(args[6]); \
+			\
+			hit = pq_value_int(rt_bodies_first_hit(&b, pq_value_as_pq_number(args[4]), pq_value_as_pq_number(args[5]), r, r)); \
+		} \
+		\
+		scratch_release(scratch); \
+		\
+		return hit; \
+	}) \
+	PROC(box_pairs, 6, \
+	{ \
+		return find_pairs(vm, args, args[4], args[5], false); \
+	}) \
+	PROC(circle_pairs, 5, \
+	{ \
+		return find_pairs(vm, args, args[3], args[4], true); \
+	}) \
+	\
+	PROC(emit, 8, \
+	{ \
+		const uint16_t n = (uint16_t)CLAMP(pq_value_as_int(args[0]), 0, (int32_t)RT_MAX_PARTICLES); \
+		const uint8_t ramp = (uint8_t)pq_value_as_int(args[7]); \
+		\
+		const uint16_t emitted = rt_particles_emit(&state->particles, n, \
+			pq_value_as_pq_number(args[1]), pq_value_as_pq_number(args[2]), \
+			pq_value_as_pq_number(args[3]), pq_value_as_pq_number(args[4]), \
+			pq_value_as_pq_number(args[5]), pq_value_as_int(args[6]), ramp); \
+		\
+		return pq_value_int(emitted); \
+	}) \
+	PROC(particle_colors, 2, \
+	{ \
+		const int32_t ramp = pq_value_as_int(args[0]); \
+		const PQ_Value colors = args[1]; \
+		\
+		if (ramp < 0 || ramp >= RT_MAX_PARTICLE_RAMPS || !pq_value_is_array(colors) || colors.a.count == 0) \
+		{ \
+			pq_vm_error(vm, "Invalid particle colors"); \
+			return pq_value_null(); \
+		} \
+		\
+		RT_Particles* p = &state->particles; \
+		\
+		p->ramp_sizes[ramp] = (uint8_t)MIN(colors.a.count, (uint16_t)RT_MAX_RAMP_COLORS); \
+		\
+		for (uint8_t i = 0; i < p->ramp_sizes[ramp]; i++) \
+		{ \
+			p->ramps[ramp][i] = (uint8_t)pq_value_as_int(pq_value_array_get(colors, i)); \
+		} \
+		\
+		return pq_value_null(); \
+	}) \
+	PROC(particle_gravity, 2, \
+	{ \
+		state->particles.gravity_x = pq_value_as_pq_number(args[0]); \
+		state->particles.gravity_y = pq_value_as_pq_number(args[1]); \
+		\
+		return pq_value_null(); \
+	}) \
+	PROC(particles, 0, \
+	{ \
+		rt_particles_step(&state->particles); \
+		\
+		submit_particles(vm); \
+		\
+		return pq_value_int(state->particles.count); \
+	}) \
+	\
+	PROC(time, 0, \
+	{ \
+		return pq_value_number(state->time_since_start); \
+	}) \
+	PROC(delta_time, 0, \
+	{ \
+		return pq_value_number(state->delta_time); \
+	}) \
+	PROC(vsync, 1, \
+	{ \
+		state->vsync = pq_value_as_boolean(args[0]); \
+		\
+		return pq_value_null(); \
+	}) \
+	PROC(frame_stats, 1, \
+	{ \
+		PQ_Value out = args[0]; \
+		\
+		if (!pq_value_is_array(out) || out.a.count < 4) \
+		{ \
+			pq_vm_error(vm, "Frame stats go into an array of at least 4 elements"); \
+			return pq_value_null(); \
+		} \
+		\
+		const RT_FrameStats* f = &state->stats; \
+		\
+		pq_value_array_set(out, 0, int64_value(f->instructions)); \
+		pq_value_array_set(out, 1, int64_value(f->native_calls)); \
+		pq_value_array_set(out, 2, int64_value(f->pixels)); \
+		pq_value_array_set(out, 3, pq_value_number(f->present_latency)); \
+		\
+		return pq_value_null(); \
 	})
 
 #define PROC(name, arg_count, ...) \
-	static void rt_proc_##name(PQ_VM* vm) \
+	static PQ_Value rt_proc_##name(PQ_VM* vm, const PQ_Value* args, uint16_t argc) \
 	{	\
 		__VA_ARGS__ \
 	}
@@ -242,27 +1198,118 @@ void rt_state_init(Arena* arena, RT_State* s)
 
 	s->canvas = rt_canvas_make(s->arena, RT_CANVAS_WIDTH, RT_CANVAS_HEIGHT);
 
+	rt_sprite_bank_init(&s->sprites, s->arena);
+	rt_tilemap_init(&s->tilemap, s->arena);
+	rt_particles_init(&s->particles, s->arena);
+
+	rt_command_buffer_init(&s->commands[0], s->arena);
+	rt_command_buffer_init(&s->commands[1], s->arena);
+
+	s->deferred = false;
+	s->recording = 0;
+	s->tilemap_recorded = false;
+
+	s->rendering = false;
+	s->rendering_frame = false;
+	s->tilemap_rendering = false;
+	s->rendered_pixels = 0;
+
+	s->clock = nullptr;
+	s->wait = nullptr;
+	s->render = nullptr;
+	s->finish = nullptr;
+
+	s->vsync = false;
+	s->frames_presented = 0;
+	s->frames_taken = 0;
+
+	s->stats = (RT_FrameStats){};
+	s->frame_instructions = 0;
+	s->frame_native_calls = 0;
+
+	s->time_since_start = 0.0f;
+	s->delta_time = 0.0f;
+	s->last_present = 0.0;
+
 	state = s;
 }
 
 #undef PROC
 #define PROC(name, arg_count, ...) \
-	pq_compiler_declare_foreign_proc((c), s(#name), (arg_count));
+	{ s(#name), (arg_count), rt_proc_##name },
+
+// blobs refer to these by their position, see RT_REGISTRY_VERSION
+static const PQ_ForeignProc RT_PROCEDURES[] =
+{
+	DEFINE_RT_PROCEDURES
+};
+
+static const PQ_ForeignRegistry RT_REGISTRY = { RT_REGISTRY_VERSION, RT_PROCEDURES, COUNT_OF(RT_PROCEDURES) };
 
 void rt_declare_procedures(PQ_Compiler* c)
 {
 	ASSERT(state);
 
-	DEFINE_RT_PROCEDURES
+	pq_compiler_declare_foreign_registry(c, &RT_REGISTRY);
 }
 
-#undef PROC
-#define PROC(name, arg_count, ...) \
-	pq_vm_bind_foreign_proc((vm), s(#name), rt_proc_##name);
-
 void rt_bind_procedures(PQ_VM* vm)
 {
 	ASSERT(state);
 
-	DEFINE_RT_PROCEDURES
-}
\ No newline at end of file
+	pq_vm_bind_foreign_registry(vm, &RT_REGISTRY);
+}
+
+// runs a procedure of the program to completion, unless it doesn't define it
+static bool run_procedure(PQ_VM* vm, uint16_t idx, const PQ_Value* args, uint16_t arg_count, RT_StopFn should_stop)
+{
+	if (idx == PQ_NO_PROCEDURE)
+	{
+		return true;
+	}
+
+	if (!pq_vm_call(vm, idx, args, arg_count))
+	{
+		return false;
+	}
+
+	while (!should_stop() && pq_execute(vm)) {}
+
+	// errors halt the vm anywhere but on the HALT it returns to
+	return !should_stop() && vm->instructions[vm->ip].type == INST_HALT;
+}
+
+bool rt_frames_wanted(const PQ_VM* vm)
+{
+	return vm->update_proc != PQ_NO_PROCEDURE || vm->draw_proc != PQ_NO_PROCEDURE;
+}
+
+bool rt_run_frame(PQ_VM* vm, RT_StopFn should_stop)
+{
+	ASSERT(state);
+
+	const PQ_Value dt = pq_value_number(state->delta_time);
+
+	if (!run_procedure(vm, vm->update_proc, &dt, 1, should_stop) || !run_procedure(vm, vm->draw_proc, nullptr, 0, should_stop))
+	{
+		return false;
+	}
+
+	present(vm);
+
+	return true;
+}
+
+void rt_render_band(RT_State* s, uint8_t band)
+{
+	const uint32_t pixels = rt_command_buffer_execute(&s->commands[s->recording ^ 1], &s->render_canvas, band);
+
+	__atomic_fetch_add(&s->rendered_pixels, pixels, __ATOMIC_RELEASE);
+}
+
+void rt_finish_render(RT_State* s)
+{
+	ASSERT(state == s);
+
+	wait_render();
+}
@@ -2,18 +2,102 @@
 
 #include <base/common.h>
 #include <base/arena.h>
+#include <base/simd.h>
 
 #include <runtime/canvas.h>
+#include <runtime/sprite.h>
+#include <runtime/tilemap.h>
+#include <runtime/commands.h>
+#include <runtime/collision.h>
+#include <runtime/particles.h>
 #include <runtime/config.h>
 
 #include <pq/vm.h>
 #include <pq/compiler.h>
 
 typedef struct RT_State RT_State;
+
+// seconds since any fixed point in time, keeps time_since_start and delta_time
+// going. they're updated on every `present`. without one time stands still.
+typedef double (*RT_ClockFn)(void);
+
+// polled between instructions while the runtime runs the program, see rt_run_frame
+typedef bool (*RT_StopFn)(void);
+
+// called by `present` with vsync on, to block until frames_taken reaches `frame`.
+// the consumer takes a frame once per display refresh, so this paces the program
+// to the display. it may give up early, when the program is being stopped.
+typedef void (*RT_WaitFn)(RT_State* s, uint32_t frame);
+
+// hands the batch of draw calls flush just recorded over to other threads, which
+// call rt_render_band once for each band. it returns right away, `finish` blocks
+// until every band is done. nothing else touches the batch until then.
+typedef void (*RT_RenderFn)(RT_State* s);
+typedef void (*RT_FinishFn)(RT_State* s);
+
+// what went into the last frame, from one `present` to the next. programs
+// read it with frame_stats(out), in this order.
+typedef struct RT_FrameStats RT_FrameStats;
+struct RT_FrameStats
+{
+	uint32_t instructions;
+	uint32_t native_calls;
+
+	// of the frame `present` showed, which in deferred mode with a `render` is
+	// the one before the frame it ended
+	uint32_t pixels;
+
+	// seconds spent in `present`, rasterizing and waiting for vsync
+	float present_latency;
+};
+
 struct RT_State
 {
 	Arena* arena;
 	RT_Canvas canvas;
+	RT_SpriteBank sprites;
+	RT_Tilemap tilemap;
+	RT_Particles particles;
+
+	// in deferred mode draw calls are recorded into one buffer while the other
+	// one is rasterized, band by band. `present` shows the frame it handed over
+	// last time, then hands over the one just recorded to `render`, so the next
+	// frame gets made while this one is rasterized. without a `render` the bands
+	// are rasterized on the thread running the program, and shown right away.
+	// a full buffer is handed over early, and so is one with a tilemap draw in
+	// it before the tilemap changes, since commands only point at it. for the
+	// same reason a sprite's key only changes once nothing is being rasterized.
+	bool deferred;
+	RT_CommandBuffer commands[2];
+	uint8_t recording;
+	bool tilemap_recorded;
+
+	// the batch being rasterized: whether `present` ended it or it draws the tilemap,
+	// and the canvas it started from, since the program goes on changing its colors.
+	// rendered_pixels is only ever accessed atomically.
+	bool rendering;
+	bool rendering_frame;
+	bool tilemap_rendering;
+	RT_Canvas render_canvas;
+	uint32_t rendered_pixels;
+
+	RT_ClockFn clock;
+	RT_WaitFn wait;
+	RT_RenderFn render;
+	RT_FinishFn finish;
+
+	// frames are numbered from 1 by `present`. the consumer of the frame buffer 
+	// stores the number of the last one it copied in frames_taken, then wakes up
+	// whoever waits on it. both are only ever accessed atomically.
+	bool vsync;
+	uint32_t frames_presented;
+	uint32_t frames_taken;
+
+	RT_FrameStats stats;
+
+	// vm totals at the start of the frame
+	uint32_t frame_instructions;
+	uint32_t frame_native_calls;
 
 	bool left_key;
 	bool right_key;
@@ -25,6 +109,7 @@ struct RT_State
 
 	float time_since_start;
 	float delta_time;
+	double last_present;
 };
 
 void rt_state_init(Arena* arena, RT_State* s);
@@ -33,4 +118,20 @@ void rt_declare_procedures(PQ_Compiler* c);
 
 void rt_bind_procedures(PQ_VM* vm);
 
+// frame mode: programs that define update(dt) or draw() (see PQ_ProcedureFlags)
+// get them called once per frame, after their top level code halted, instead 
+// of looping forever themselves.
+bool rt_frames_wanted(const PQ_VM* vm);
+
+// runs update(delta_time) then draw(), and presents. the host paces the calls.
+// returns false once the program stopped, with an error or because `should_stop` said so.
+bool rt_run_frame(PQ_VM* vm, RT_StopFn should_stop);
+
+// rasterizes one band of the batch handed over to `render`, on any thread
+void rt_render_band(RT_State* s, uint8_t band);
+
+// waits for the batch being rasterized, and shows it if `present` ended it. hosts
+// with a `render` call it once the program stopped, or its last frame is lost.
+void rt_finish_render(RT_State* s);
+
 extern void rt_print(const char*);
\ No newline at end of file
@@ -0,0 +1,200 @@
+#include <runtime/tilemap.h>
+
+static uint16_t tileset_columns(const RT_Tilemap* tm)
+{
+	return tm->tileset->width / tm->tile_width;
+}
+
+static uint16_t tileset_tile_count(const RT_Tilemap* tm)
+{
+	return MIN((uint16_t)(tileset_columns(tm) * (tm->tileset->height / tm->tile_height)), (uint16_t)RT_TILE_NONE);
+}
+
+static RT_TileKind classify_tile(const RT_Tilemap* tm, uint8_t tile)
+{
+	const RT_Bitmap* b = tm->tileset;
+
+	if (b->key < 0)
+	{
+		return RT_TILE_OPAQUE;
+	}
+
+	const uint16_t sx = (tile % tileset_columns(tm)) * tm->tile_width;
+	const uint16_t sy = (tile / tileset_columns(tm)) * tm->tile_height;
+
+	uint16_t keyed = 0;
+
+	for (uint16_t y = sy; y < sy + tm->tile_height; y++)
+	{
+		for (uint16_t x = sx; x < sx + tm->tile_width; x++)
+		{
+			keyed += b->pixels[x + y * b->width] == b->key;
+		}
+	}
+
+	if (keyed == 0)
+	{
+		return RT_TILE_OPAQUE;
+	}
+
+	if (keyed == tm->tile_width * tm->tile_height)
+	{
+		return RT_TILE_EMPTY;
+	}
+
+	return RT_TILE_MASKED;
+}
+
+// the key of the tileset may change at any point, in which case the tiles get classified again.
+static void classify_tiles(RT_Tilemap* tm)
+{
+	if (tm->kinds_valid && tm->kinds_key == tm->tileset->key)
+	{
+		return;
+	}
+
+	const uint16_t count = tileset_tile_count(tm);
+
+	for (uint16_t i = 0; i < 256; i++)
+	{
+		tm->kinds[i] = i < count ? classify_tile(tm, i) : RT_TILE_EMPTY;
+	}
+
+	tm->kinds_key = tm->tileset->key;
+	tm->kinds_valid = true;
+}
+
+void rt_tilemap_init(RT_Tilemap* tm, Arena* arena)
+{
+	*tm = (RT_Tilemap){};
+
+	ArenaTag tag = arena_set_tag(arena, ARENA_TAG_TILEMAP);
+
+	tm->tiles = arena_push_array_uninit(arena, uint8_t, RT_MAX_TILEMAP_SIZE * RT_MAX_TILEMAP_SIZE);
+
+	arena_set_tag(arena, tag);
+}
+
+bool rt_tilemap_setup(RT_Tilemap* tm, const RT_Bitmap* tileset, uint8_t tile_width, uint8_t tile_height, uint16_t columns, uint16_t rows)
+{
+	if (columns > RT_MAX_TILEMAP_SIZE || rows > RT_MAX_TILEMAP_SIZE || tile_width == 0 || tile_height == 0)
+	{
+		return false;
+	}
+
+	if (tile_width > tileset->width || tile_height > tileset->height)
+	{
+		return false;
+	}
+
+	tm->tileset = tileset;
+
+	tm->tile_width = tile_width;
+	tm->tile_height = tile_height;
+
+	tm->columns = columns;
+	tm->rows = rows;
+
+	tm->scroll_x = 0;
+	tm->scroll_y = 0;
+
+	tm->kinds_valid = false;
+
+	__builtin_memset(tm->tiles, RT_TILE_NONE, columns * rows);
+	__builtin_memset(tm->row_counts, 0, sizeof(tm->row_counts));
+
+	return true;
+}
+
+void rt_tilemap_set(RT_Tilemap* tm, int16_t column, int16_t row, uint8_t tile)
+{
+	if (column < 0 || row < 0 || column >= tm->columns || row >= tm->rows)
+	{
+		return;
+	}
+
+	uint8_t* t = &tm->tiles[column + row * tm->columns];
+
+	tm->row_counts[row] += (tile != RT_TILE_NONE) - (*t != RT_TILE_NONE);
+
+	*t = tile;
+}
+
+uint8_t rt_tilemap_get(const RT_Tilemap* tm, int16_t column, int16_t row)
+{
+	if (column < 0 || row < 0 || column >= tm->columns || row >= tm->rows)
+	{
+		return RT_TILE_NONE;
+	}
+
+	return tm->tiles[column + row * tm->columns];
+}
+
+void rt_tilemap_classify(RT_Tilemap* tm)
+{
+	if (tm->tileset)
+	{
+		classify_tiles(tm);
+	}
+}
+
+void rt_tilemap_draw(RT_Tilemap* tm, RT_Canvas* c, int16_t scroll_x, int16_t scroll_y)
+{
+	if (!tm->tileset)
+	{
+		return;
+	}
+
+	classify_tiles(tm);
+
+	const int16_t tw = tm->tile_width;
+	const int16_t th = tm->tile_height;
+
+	// visible range of tiles, in map space
+	const int32_t left = scroll_x;
+	const int32_t top = scroll_y + c->clip_top;
+	const int32_t right = left + c->width;
+	const int32_t bottom = scroll_y + c->clip_bottom;
+
+	if (right <= 0 || bottom <= 0)
+	{
+		return;
+	}
+
+	const int16_t first_column = MAX(left, 0) / tw;
+	const int16_t first_row = MAX(top, 0) / th;
+	const int16_t last_column = MIN((right - 1) / tw, (int32_t)tm->columns - 1);
+	const int16_t last_row = MIN((bottom - 1) / th, (int32_t)tm->rows - 1);
+
+	const uint16_t columns = tileset_columns(tm);
+
+	// opaque tiles skip the key test and get copied row by row
+	RT_Bitmap opaque = *tm->tileset;
+	opaque.key = -1;
+
+	for (int16_t row = first_row; row <= last_row; row++)
+	{
+		if (tm->row_counts[row] == 0)
+		{
+			continue;
+		}
+
+		const uint8_t* tiles = tm->tiles + row * tm->columns;
+
+		for (int16_t column = first_column; column <= last_column; column++)
+		{
+			const uint8_t tile = tiles[column];
+
+			const RT_TileKind kind = tm->kinds[tile];
+
+			if (kind == RT_TILE_EMPTY)
+			{
+				continue;
+			}
+
+			rt_canvas_blit(c, kind == RT_TILE_OPAQUE ? &opaque : tm->tileset, 
+				(tile % columns) * tw, (tile / columns) * th, tw, th, 
+				column * tw - scroll_x, row * th - scroll_y, 0);
+		}
+	}
+}
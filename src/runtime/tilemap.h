@@ -0,0 +1,57 @@
+#pragma once
+
+#include <base/common.h>
+#include <base/arena.h>
+
+#include <runtime/canvas.h>
+#include <runtime/config.h>
+
+static constexpr uint8_t RT_TILE_NONE = 0xff;
+
+typedef enum : uint8_t
+{
+	RT_TILE_EMPTY,
+	RT_TILE_OPAQUE,
+	RT_TILE_MASKED,
+} RT_TileKind;
+
+// a grid of indices into a tileset, which is a sprite cut into `tile_width` x `tile_height` cells.
+typedef struct RT_Tilemap RT_Tilemap;
+struct RT_Tilemap
+{
+	uint8_t* tiles;
+
+	uint16_t columns;
+	uint16_t rows;
+
+	// amount of non-empty tiles in each row, so empty rows are skipped entirely
+	uint16_t row_counts[RT_MAX_TILEMAP_SIZE];
+
+	const RT_Bitmap* tileset;
+
+	uint8_t tile_width;
+	uint8_t tile_height;
+
+	// what each tile of the tileset looks like, relative to the key it was computed for
+	RT_TileKind kinds[256];
+	int16_t kinds_key;
+	bool kinds_valid;
+
+	int16_t scroll_x;
+	int16_t scroll_y;
+};
+
+void rt_tilemap_init(RT_Tilemap* tm, Arena* arena);
+
+bool rt_tilemap_setup(RT_Tilemap* tm, const RT_Bitmap* tileset, uint8_t tile_width, uint8_t tile_height, uint16_t columns, uint16_t rows);
+
+void rt_tilemap_set(RT_Tilemap* tm, int16_t column, int16_t row, uint8_t tile);
+
+uint8_t rt_tilemap_get(const RT_Tilemap* tm, int16_t column, int16_t row);
+
+// classifies the tiles again if the key of the tileset changed. draws do it too,
+// but bands drawn on several threads at once only read what's done beforehand.
+void rt_tilemap_classify(RT_Tilemap* tm);
+
+// draws the map with its top left corner at (-scroll_x, -scroll_y)
+void rt_tilemap_draw(RT_Tilemap* tm, RT_Canvas* c, int16_t scroll_x, int16_t scroll_y);
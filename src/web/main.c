@@ -143,6 +143,9 @@ static void post_rt(const RT_State* rt)
 
 	js_set_int(msg, "timeSinceStartPtr", (intptr_t)&rt->time_since_start);
 
+	js_set_int(msg, "framesPresentedPtr", (intptr_t)&rt->frames_presented);
+	js_set_int(msg, "framesTakenPtr", (intptr_t)&rt->frames_taken);
+
 	js_post_message(msg);
 }
 
@@ -155,6 +158,72 @@ static Arena rt_arena;
 
 static atomic_bool should_stop;
 
+static double web_clock()
+{
+	return js_now() / 1000.0;
+}
+
+static bool web_should_stop()
+{
+	return atomic_load(&should_stop);
+}
+
+// sleeps until the next frame is due, instead of spinning. nothing ever
+// notifies `frame_waiter`, the wait always times out. a late frame starts
+// the schedule over, rather than rushing through the ones it missed.
+static void wait_for_frame(double* deadline)
+{
+	static int32_t frame_waiter = 0;
+
+	*deadline += 1000.0 / RT_FRAME_RATE;
+
+	const double now = js_now();
+
+	if (*deadline <= now)
+	{
+		*deadline = now;
+		return;
+	}
+
+	__builtin_wasm_memory_atomic_wait32(&frame_waiter, 0, (int64_t)((*deadline - now) * 1000000.0));
+}
+
+// sleeps until the page copied the frame out, on its next animation frame. the
+// page wakes it up, the timeout is only there to notice the program being stopped.
+static void web_wait(RT_State* s, uint32_t frame)
+{
+	while (!atomic_load(&should_stop))
+	{
+		const uint32_t taken = __atomic_load_n(&s->frames_taken, __ATOMIC_ACQUIRE);
+
+		if ((int32_t)(taken - frame) >= 0)
+		{
+			return;
+		}
+
+		__builtin_wasm_memory_atomic_wait32((int32_t*)&s->frames_taken, (int32_t)taken, 100 * 1000000ll);
+	}
+}
+
+// runs the top level code, then the frames of programs that define update or draw
+static void run(PQ_VM* vm)
+{
+	while (!atomic_load(&should_stop) && pq_execute(vm)) {}
+
+	if (had_error || !rt_frames_wanted(vm))
+	{
+		return;
+	}
+
+	double deadline = js_now();
+
+	do
+	{
+		wait_for_frame(&deadline);
+	}
+	while (rt_run_frame(vm, web_should_stop));
+}
+
 atomic_bool* should_stop_ptr()
 {
 	return &should_stop;
@@ -165,10 +234,10 @@ static PQ_CompiledBlob blob;
 void init() 
 {
 	static uint8_t compiler_mem[4 * 1024 * 1024];
-	compiler_arena = arena_make(compiler_mem, sizeof(compiler_mem));
+	compiler_arena = arena_make_zeroed(compiler_mem, sizeof(compiler_mem));
 
-	static uint8_t rt_mem[256 * 1024];
-	rt_arena = arena_make(rt_mem, sizeof(rt_mem));
+	static uint8_t rt_mem[384 * 1024];
+	rt_arena = arena_make_zeroed(rt_mem, sizeof(rt_mem));
 
 	atomic_store(&should_stop, true);
 }
@@ -187,7 +256,7 @@ void compile_and_export(__externref_t e)
 	String source = {};
 
 	source.length = (size_t)js_get_int(e, "length");
-	source.buffer = arena_push_array(&compiler_arena, char, source.length);
+	source.buffer = arena_push_array_uninit(&compiler_arena, char, source.length);
 	
 	js_get_string(e, "source", source.buffer);
 
@@ -216,18 +285,28 @@ void compile_and_export(__externref_t e)
 
 void run_from_blob(__externref_t e)
 {
+	had_error = false;
+
 	arena_reset(&rt_arena);
 
 	RT_State rt = {};
 
 	rt_state_init(&rt_arena, &rt);
 
+	rt.clock = web_clock;
+	rt.wait = web_wait;
+
 	post_rt(&rt);
 
 	blob = (PQ_CompiledBlob){};
 
 	blob.size = js_get_int(e, "length");
-	blob.buffer = arena_push_array(&rt_arena, uint8_t, blob.size);
+
+	ArenaTag tag = arena_set_tag(&rt_arena, ARENA_TAG_BLOB);
+
+	blob.buffer = arena_push_array_uninit(&rt_arena, uint8_t, blob.size);
+
+	arena_set_tag(&rt_arena, tag);
 
 	js_memcpy(blob.buffer, js_get(e, "buffer"), blob.size);
 
@@ -236,7 +315,7 @@ void run_from_blob(__externref_t e)
 	pq_vm_init(&vm, &rt_arena, &blob, vm_error_fn);
 	rt_bind_procedures(&vm);
 
-	while (!atomic_load(&should_stop) && pq_execute(&vm)) {}
+	run(&vm);
 }
 
 void compile_and_run(__externref_t e)
@@ -253,7 +332,7 @@ void compile_and_run(__externref_t e)
 	String source = {};
 
 	source.length = (size_t)js_get_int(e, "length");
-	source.buffer = arena_push_array(&compiler_arena, char, source.length);
+	source.buffer = arena_push_array_uninit(&compiler_arena, char, source.length);
 	
 	js_get_string(e, "source", source.buffer);
 
@@ -269,6 +348,9 @@ void compile_and_run(__externref_t e)
 		return;
 	}
 
+	rt.clock = web_clock;
+	rt.wait = web_wait;
+
 	post_rt(&rt);
 
 	printf("blob size: %d", blob.size);
@@ -278,11 +360,17 @@ void compile_and_run(__externref_t e)
 	pq_vm_init(&vm, &rt_arena, &blob, vm_error_fn);
 	rt_bind_procedures(&vm);
 
-	while (!atomic_load(&should_stop) && pq_execute(&vm)) {}
+	run(&vm);
 }
 
 #include <pq/compiler.c>
 #include <pq/vm.c>
+#include <pq/profiler.c>
 
 #include <runtime/canvas.c>
+#include <runtime/sprite.c>
+#include <runtime/tilemap.c>
+#include <runtime/commands.c>
+#include <runtime/collision.c>
+#include <runtime/particles.c>
 #include <runtime/state.c>
\ No newline at end of file
@@ -33,6 +33,9 @@ extern __externref_t js_get(__externref_t, const char*);
 
 extern void js_memcpy(void*, __externref_t, int32_t);
 
+// performance.now(), milliseconds
+extern double js_now();
+
 //
 // helpers
 //